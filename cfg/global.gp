@@ -36,6 +36,8 @@ preload 8388608
 chunk 4096
 
 # How long to wait (in milliseconds) for the new data in regular files.
+# Export takes only the data that arrives within this time from the live
+# sources like sockets or serial ports.
 #
 timeout 10000
 
@@ -70,9 +72,13 @@ thickness 0
 
 # Default figure drawing.
 #
-# <1> Name of the drawing ("line", "dash", "dot").
+# <1> Name of the drawing ("line", "dash", "dot", "density").
 # <2> Width of the figure.
 #
+# The "density" drawing is a heatmap of a dot figure. Each sample increments
+# the hit count of the pixels it covers and pixel brightness grows with the
+# logarithm of the count. It is useful for dense scatter plots like VSI X/Y.
+#
 drawing line 2
 
 # How to print filenames in UI (0 = full length, <n> = cut to \n dirs in path).
@@ -87,3 +93,34 @@ precision 9
 #
 lz4_compress 0
 
+# Convert only the text columns that are referenced by pages, figures or
+# subtractions. The rest of columns are taken as NaN. The file is read again
+# when you refer to another column from UI. This saves parsing time only,
+# rows are still stored in full width so memory usage does not change.
+#
+projection 0
+
+# Keep the offset of every Nth row of text files in the index file next to
+# data (FILE.gpindex). The index is reused while the file size and its
+# modification time do not change. With index the dataset of fixed length
+# is loaded from the tail of file, and the stride that is a multiple of N
+# takes only the indexed rows. Zero disables the index.
+#
+index 0
+
+
+# Load only one row out of each N rows. Rows of binary files are skipped by
+# seeking so they are not read at all. The same is done for text files
+# with index (see above).
+#
+stride 1
+
+# Load only the rows with time column within the window. The time is
+# expected to be non-decreasing so the start of the window is found by
+# bisection of binary files or text index, and reading stops at the end.
+#
+# <1> Number of the time column (-1 disables the window).
+# <2> Start time.
+# <3> End time.
+#
+window -1 0 0
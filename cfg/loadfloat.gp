@@ -11,19 +11,39 @@ include "global.gp"
 # <2> Number of lines to allocate appropriate amount of memory. If the file has
 #     more lines the last ones will disappear from plot. Value 0 means automatic
 #     determination based on file size.
-# <3> File format ("text", "float", "double").
+# <3> File format ("text", "float", "double", "struct", "npy").
 # <4> Number of columns.
 # <5> Name of the file.
 #
 load 0 0 float 24 "data.f"
 #load 0 0 double 200 "data.d"
 
+# The "struct" format takes the record layout instead of the number of
+# columns. Each field is "type[*count][:scale[:offset]]" and produces count
+# columns of type (u8, i8, u16, i16, u32, i32, u64, i64, f32, f64) that are
+# converted as value * scale + offset. Prefix "<" or ">" selects little or
+# big endian byte order for this and the following fields. The "x*count"
+# field skips padding bytes.
+#
+#load 0 0 struct "<u32:0.001 i16*6:0.01 f32*4 u8 x*3" "dump.bin"
+
+# The "npy" format loads 1-D or 2-D NumPy array of integer or float dtype in
+# C or Fortran order. The number of columns is taken from the array shape.
+# The file is mapped into memory and is recognized even if loaded as "text".
+#
+#load 0 0 npy "result.npy"
+
 # If you specify a text file format the remaining parameters will be
 # different. The number of columns is not specified but is determined by the
 # content of the file.
 #
 #load 0 0 text "tel20hz.txt"
 
+# Text and binary files that are compressed to LZ4 frame format (as "lz4"
+# utility does) are decoded on the fly while loading.
+#
+#load 0 0 text "tel20hz.txt.lz4"
+
 # Select the dataset by number. Make sense only if there are several ones.
 #
 bind 0
@@ -113,6 +133,17 @@ page "DQ Current"
 		drawing line 0
 		#drawing dot 4
 
+		# Persistence mode overlays the figure segments on top of each
+		# other like an oscilloscope does. Older segments fade out.
+		#
+		# <1> How to cut segments ("period", "trigger").
+		# <2> Period in units of X or number of the trigger column. New
+		# segment starts when the trigger value rises above zero.
+		# <3> Decay factor per segment (0 < decay <= 1).
+		#
+		#persist period 0.02 0.95
+		#persist trigger 12 0.95
+
 	# Define slave axis.
 	#
 	# <1> Number of the axis to be slave.
@@ -9,6 +9,38 @@ chunk 20
 #
 load 0 10000 text "/dev/rfcomm0"
 #load 0 10000 text "//./COM1"
+
+# Telemetry can also come from a socket (not available on Windows). With
+# "tcp" and "unix" we connect to a stream server and read until it closes.
+# With "udp" we bind to a local port (host may be empty) and take whole
+# records or lines from each datagram, the partial record at the end of
+# datagram is dropped. Any text or binary format can be used. Socket
+# receive buffer size is taken from preload.
+#
+#load 0 10000 text "tcp:127.0.0.1:5000"
+#load 0 10000 text "unix:/tmp/telemetry.sock"
+#load 0 10000 float 4 "udp::5000"
+
+# Producer on the same host can put rows into a POSIX shared memory ring
+# (not available on Windows). Rows are of fixed size given by float,
+# double or struct format and are decoded right from the ring. The object
+# begins with a header, all fields are in host byte order.
+#
+#	0	char magic[8]		"GPRING1" with trailing zero
+#	8	uint32 header_size	offset of the first row, at least 192
+#	12	uint32 row_size		must match the format
+#	16	uint64 capacity		number of rows in the ring
+#	24	uint32 closed		producer sets it at the end
+#	64	uint64 head		rows written by producer
+#	128	uint64 tail		rows released by us
+#
+# Counters never wrap, row N is at header_size + (N % capacity) * row_size.
+# Producer writes rows then stores head with release semantics and waits
+# while head - tail is equal to capacity. We take the rows from tail so the
+# ring may be reopened. Dataset is done when producer has closed the ring
+# or no rows have arrived within timeout.
+#
+#load 0 10000 float 4 "shm:/telemetry"
 mkpages -1
 
 group 0 -1
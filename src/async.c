@@ -21,115 +21,1745 @@
 #include <string.h>
 #include <errno.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* __SSE2__ */
+
+#ifndef _WINDOWS
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif /* _WINDOWS */
+
 #include <SDL2/SDL.h>
 
-#include "async.h"
-#include "plot.h"
+#include "async.h"
+#include "plot.h"
+
+#include "lz4/lz4.h"
+
+static Uint32		async_EVENT = (Uint32) -1;
+
+Uint32 async_init()
+{
+	async_EVENT = SDL_RegisterEvents(1);
+
+	return async_EVENT;
+}
+
+/* Find the first CR or LF in the span [s, e). Return e if there is no line
+ * end in the span.
+ * */
+static char *
+async_eol(char *s, char *e)
+{
+#ifdef __SSE2__
+	const __m128i	cr = _mm_set1_epi8('\r');
+	const __m128i	lf = _mm_set1_epi8('\n');
+
+	__m128i		x;
+	int		m;
+
+	while (e - s >= 16) {
+
+		x = _mm_loadu_si128((const __m128i *) s);
+		m = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, cr),
+					_mm_cmpeq_epi8(x, lf)));
+
+		if (m != 0)
+			return s + __builtin_ctz(m);
+
+		s += 16;
+	}
+
+	while (s < e && *s != '\r' && *s != '\n')
+		++s;
+
+	return s;
+#else /* __SSE2__ */
+	char		*q, *r;
+
+	q = memchr(s, '\n', e - s);
+	q = (q != NULL) ? q : e;
+
+	r = memchr(s, '\r', q - s);
+
+	return (r != NULL) ? r : q;
+#endif
+}
+
+static void
+async_notify(async_FILE *afd)
+{
+	SDL_Event		ev;
+
+	if (SDL_AtomicCAS(&afd->hungry, 1, 0) == SDL_TRUE) {
+
+		if (async_EVENT != (Uint32) -1) {
+
+			memset(&ev, 0, sizeof(ev));
+
+			ev.type = async_EVENT;
+			ev.user.data1 = (void *) afd;
+
+			SDL_PushEvent(&ev);
+		}
+	}
+}
+
+static int
+async_starve(async_FILE *afd, int wp)
+{
+	SDL_AtomicSet(&afd->hungry, 1);
+
+	/* Data could arrive before we became hungry.
+	 * */
+	if (SDL_AtomicGet(&afd->wp) != wp) {
+
+		async_notify(afd);
+	}
+
+	return ASYNC_NO_DATA_READY;
+}
+
+static void
+async_feed(async_FILE *afd)
+{
+	if (SDL_AtomicCAS(&afd->full, 1, 0) == SDL_TRUE) {
+
+		SDL_SemPost(afd->sem_space);
+	}
+}
+
+static Uint32
+async_le32(const unsigned char *p)
+{
+	return (Uint32) p[0] | ((Uint32) p[1] << 8)
+		| ((Uint32) p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+static int
+async_lz4_skip(async_lz4_t *lz, long n)
+{
+	unsigned char	tbuf[256];
+	long		len;
+
+	while (n > 0) {
+
+		len = (n > (long) sizeof(tbuf)) ? (long) sizeof(tbuf) : n;
+
+		if (fread(tbuf, 1, len, lz->fd) != (size_t) len)
+			return 0;
+
+		n -= len;
+	}
+
+	return 1;
+}
+
+/* Decode the next block of LZ4 frame into the buffer after the history.
+ * Return zero at the end of stream or on error.
+ * */
+static int
+async_lz4_block(async_lz4_t *lz)
+{
+	unsigned char	hbuf[16];
+	Uint32		magic, size;
+	int		max, r, n;
+
+	do {
+		if (lz->frame == 0) {
+
+			if (fread(hbuf, 4, 1, lz->fd) != 1)
+				return 0;
+
+			magic = async_le32(hbuf);
+
+			if ((magic & 0xFFFFFFF0U) == 0x184D2A50U) {
+
+				/* Skippable frame has user data only.
+				 * */
+				if (		fread(hbuf, 4, 1, lz->fd) != 1
+						|| async_lz4_skip(lz, async_le32(hbuf)) == 0)
+					return 0;
+
+				continue;
+			}
+
+			if (		magic != 0x184D2204U
+					|| fread(hbuf, 2, 1, lz->fd) != 1) {
+
+				ERROR("Invalid LZ4 frame\n");
+				return 0;
+			}
+
+			lz->flag = hbuf[0];
+
+			if ((lz->flag & 0xC0) != 0x40 || (lz->flag & 0x01) != 0) {
+
+				ERROR("Unsupported LZ4 frame version or dictionary\n");
+				return 0;
+			}
+
+			/* Content size is optional, header checksum is not
+			 * verified.
+			 * */
+			n = ((lz->flag & 0x08) ? 8 : 0) + 1;
+
+			if (fread(hbuf + 2, n, 1, lz->fd) != 1)
+				return 0;
+
+			max = (hbuf[1] >> 4) & 7;
+
+			if (max < 4) {
+
+				ERROR("Invalid LZ4 block size\n");
+				return 0;
+			}
+
+			max = 1 << (8 + 2 * max);
+
+			if (max > lz->block_max) {
+
+				free(lz->src);
+				free(lz->dst);
+
+				lz->src = (char *) malloc(max);
+				lz->dst = (char *) malloc(ASYNC_LZ4_DICT + max);
+				lz->block_max = (lz->src != NULL && lz->dst != NULL) ? max : 0;
+
+				if (lz->block_max == 0) {
+
+					ERROR("No memory allocated for LZ4 block\n");
+					return 0;
+				}
+			}
+
+			lz->frame = 1;
+			lz->hist = 0;
+			lz->len = 0;
+		}
+
+		if (fread(hbuf, 4, 1, lz->fd) != 1)
+			return 0;
+
+		size = async_le32(hbuf);
+
+		if (size == 0U) {
+
+			/* End mark could be followed by content checksum.
+			 * */
+			if (		(lz->flag & 0x04) != 0
+					&& fread(hbuf, 4, 1, lz->fd) != 1)
+				return 0;
+
+			lz->frame = 0;
+			continue;
+		}
+
+		if ((size & 0x7FFFFFFFU) > (Uint32) lz->block_max) {
+
+			ERROR("Invalid LZ4 block of %u bytes\n", size & 0x7FFFFFFFU);
+			return 0;
+		}
+
+		/* Linked blocks refer to the data we decoded before so we
+		 * keep the last 64K of it just before the next block.
+		 * */
+		if ((lz->flag & 0x20) == 0) {
+
+			n = lz->hist + lz->len;
+			n = (n > ASYNC_LZ4_DICT) ? ASYNC_LZ4_DICT : n;
+
+			memmove(lz->dst + ASYNC_LZ4_DICT - n,
+					lz->dst + ASYNC_LZ4_DICT + lz->len - n, n);
+
+			lz->hist = n;
+		}
+
+		if ((size & 0x80000000U) != 0U) {
+
+			size &= 0x7FFFFFFFU;
+
+			if (fread(lz->dst + ASYNC_LZ4_DICT, size, 1, lz->fd) != 1)
+				return 0;
+
+			r = (int) size;
+		}
+		else {
+			if (fread(lz->src, size, 1, lz->fd) != 1)
+				return 0;
+
+			if ((lz->flag & 0x20) == 0) {
+
+				r = LZ4_decompress_safe_usingDict(lz->src, lz->dst + ASYNC_LZ4_DICT,
+						(int) size, lz->block_max,
+						lz->dst + ASYNC_LZ4_DICT - lz->hist, lz->hist);
+			}
+			else {
+				r = LZ4_decompress_safe(lz->src, lz->dst + ASYNC_LZ4_DICT,
+						(int) size, lz->block_max);
+			}
+
+			if (r < 0) {
+
+				ERROR("Corrupted LZ4 block\n");
+				return 0;
+			}
+		}
+
+		if (		(lz->flag & 0x10) != 0
+				&& fread(hbuf, 4, 1, lz->fd) != 1)
+			return 0;
+
+		lz->pos = 0;
+		lz->len = r;
+	}
+	while (lz->len == 0);
+
+	return lz->len;
+}
+
+async_lz4_t *async_lz4_open(FILE *fd)
+{
+	async_lz4_t	*lz;
+	unsigned char	magic[4];
+	int		r;
+
+	r = (fread(magic, 4, 1, fd) == 1
+			&& async_le32(magic) == 0x184D2204U) ? 1 : 0;
+
+	fseek(fd, 0L, SEEK_SET);
+
+	if (r == 0)
+		return NULL;
+
+	lz = calloc(1, sizeof(async_lz4_t));
+
+	if (lz == NULL) {
+
+		ERROR("No memory allocated for LZ4 decoder\n");
+		return NULL;
+	}
+
+	lz->fd = fd;
+
+	return lz;
+}
+
+void async_lz4_close(async_lz4_t *lz)
+{
+	free(lz->src);
+	free(lz->dst);
+	free(lz);
+}
+
+int async_lz4_read(async_lz4_t *lz, char *sbuf, int n)
+{
+	int		nr = 0, len;
+
+	while (nr < n) {
+
+		if (lz->pos >= lz->len) {
+
+			if (async_lz4_block(lz) == 0)
+				break;
+		}
+
+		len = lz->len - lz->pos;
+		len = (len > n - nr) ? n - nr : len;
+
+		if (sbuf != NULL) {
+
+			memcpy(sbuf + nr, lz->dst + ASYNC_LZ4_DICT + lz->pos, len);
+		}
+
+		lz->pos += len;
+		nr += len;
+	}
+
+	return nr;
+}
+
+int async_lz4_getc(async_lz4_t *lz)
+{
+	if (lz->pos >= lz->len) {
+
+		if (async_lz4_block(lz) == 0)
+			return EOF;
+	}
+
+	return (unsigned char) lz->dst[ASYNC_LZ4_DICT + lz->pos++];
+}
+
+void async_lz4_ungetc(async_lz4_t *lz)
+{
+	lz->pos -= (lz->pos > 0) ? 1 : 0;
+}
+
+int async_sock_name(const char *name)
+{
+	return (	strncmp(name, "tcp:", 4) == 0
+			|| strncmp(name, "udp:", 4) == 0
+			|| strncmp(name, "unix:", 5) == 0) ? 1 : 0;
+}
+
+#ifdef _WINDOWS
+async_sock_t *async_sock_open(const char *name, int rcvbuf)
+{
+	ERROR("Socket \"%s\" is not supported on this platform\n", name);
+
+	return NULL;
+}
+
+void async_sock_close(async_sock_t *sk)
+{
+	free(sk);
+}
+
+int async_sock_read(async_sock_t *sk, char *sbuf, int n)
+{
+	return -1;
+}
+
+int async_sock_getc(async_sock_t *sk)
+{
+	return EOF;
+}
+
+void async_sock_ungetc(async_sock_t *sk)
+{
+}
+
+#else /* _WINDOWS */
+async_sock_t *async_sock_open(const char *name, int rcvbuf)
+{
+	async_sock_t		*sk;
+	struct addrinfo		hints, *ai, *ap;
+	struct sockaddr_un	un;
+	struct timeval		tv;
+	char			host[256], *port;
+	int			sock, rc;
+
+	memset(&hints, 0, sizeof(hints));
+
+	if (strncmp(name, "unix:", 5) == 0) {
+
+		memset(&un, 0, sizeof(un));
+
+		un.sun_family = AF_UNIX;
+		strncpy(un.sun_path, name + 5, sizeof(un.sun_path) - 1);
+
+		sock = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if (sock < 0) {
+
+			ERROR("socket(\"%s\"): %s\n", name, strerror(errno));
+			return NULL;
+		}
+
+		rc = connect(sock, (struct sockaddr *) &un, sizeof(un));
+		hints.ai_socktype = SOCK_STREAM;
+	}
+	else {
+		/* Name is "tcp:HOST:PORT" or "udp:HOST:PORT". Empty HOST
+		 * of UDP means that we receive from any address.
+		 * */
+		strncpy(host, name + 4, sizeof(host) - 1);
+		host[sizeof(host) - 1] = 0;
+
+		port = strrchr(host, ':');
+
+		if (port == NULL) {
+
+			ERROR("No port number in \"%s\"\n", name);
+			return NULL;
+		}
+
+		*port++ = 0;
+
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = (name[0] == 't') ? SOCK_STREAM : SOCK_DGRAM;
+		hints.ai_flags = (name[0] == 't') ? 0 : AI_PASSIVE;
+
+		rc = getaddrinfo((host[0] != 0) ? host : NULL, port, &hints, &ai);
+
+		if (rc != 0) {
+
+			ERROR("getaddrinfo(\"%s\"): %s\n", name, gai_strerror(rc));
+			return NULL;
+		}
+
+		sock = -1;
+		rc = -1;
+
+		/* Try each of the addresses until one is opened.
+		 * */
+		for (ap = ai; ap != NULL && rc != 0; ap = ap->ai_next) {
+
+			if (sock >= 0) {
+
+				close(sock);
+			}
+
+			sock = socket(ap->ai_family, ap->ai_socktype, ap->ai_protocol);
+
+			if (sock < 0)
+				continue;
+
+			if (hints.ai_socktype == SOCK_STREAM) {
+
+				rc = connect(sock, ap->ai_addr, ap->ai_addrlen);
+			}
+			else {
+				rc = bind(sock, ap->ai_addr, ap->ai_addrlen);
+			}
+		}
+
+		freeaddrinfo(ai);
+	}
+
+	if (rc != 0) {
+
+		ERROR("Unable to open \"%s\": %s\n", name, strerror(errno));
+
+		if (sock >= 0) {
+
+			close(sock);
+		}
+
+		return NULL;
+	}
+
+	/* Large receive buffer lets us not to drop datagrams while the
+	 * ring is full for a moment.
+	 * */
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	tv.tv_sec = 0;
+	tv.tv_usec = ASYNC_SOCK_WAIT * 1000;
+
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	sk = calloc(1, sizeof(async_sock_t));
+
+	if (sk != NULL) {
+
+		sk->buf = (char *) malloc(ASYNC_SOCK_SIZE);
+	}
+
+	if (sk == NULL || sk->buf == NULL) {
+
+		ERROR("No memory allocated for socket buffer\n");
+		close(sock);
+		free(sk);
+		return NULL;
+	}
+
+	sk->sock = sock;
+	sk->type = hints.ai_socktype;
+
+	return sk;
+}
+
+void async_sock_close(async_sock_t *sk)
+{
+	/* Socket itself is closed along with the FILE that wraps it.
+	 * */
+	free(sk->buf);
+	free(sk);
+}
+
+/* Receive the next piece of data. Return zero if nothing has arrived
+ * during the wait time and negative if stream is closed.
+ * */
+static int
+async_sock_fetch(async_sock_t *sk)
+{
+	int		r;
+
+	if (sk->closed != 0)
+		return -1;
+
+	r = (int) recv(sk->sock, sk->buf, ASYNC_SOCK_SIZE - 1, 0);
+
+	if (r > 0 && sk->type == SOCK_DGRAM) {
+
+		if (sk->record > 0) {
+
+			/* Drop the partial record at the end of datagram.
+			 * */
+			r -= r % sk->record;
+		}
+		else if (sk->buf[r - 1] != '\n') {
+
+			/* Text line ends with datagram.
+			 * */
+			sk->buf[r++] = '\n';
+		}
+	}
+
+	if (r > 0) {
+
+		sk->pos = 0;
+		sk->len = r;
+	}
+	else if (r == 0) {
+
+		/* Zero length datagram is valid but stream has ended.
+		 * */
+		sk->closed = (sk->type == SOCK_STREAM) ? 1 : 0;
+	}
+	else {
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+
+			sk->closed = 1;
+		}
+
+		r = 0;
+	}
+
+	return (sk->closed != 0) ? -1 : r;
+}
+
+int async_sock_read(async_sock_t *sk, char *sbuf, int n)
+{
+	int		r;
+
+	if (sk->pos >= sk->len) {
+
+		r = async_sock_fetch(sk);
+
+		if (r <= 0)
+			return r;
+	}
+
+	r = sk->len - sk->pos;
+	r = (r > n) ? n : r;
+
+	if (sbuf != NULL) {
+
+		memcpy(sbuf, sk->buf + sk->pos, r);
+	}
+
+	sk->pos += r;
+
+	return r;
+}
+
+int async_sock_getc(async_sock_t *sk)
+{
+	if (sk->pos >= sk->len) {
+
+		if (async_sock_fetch(sk) <= 0)
+			return EOF;
+	}
+
+	return (unsigned char) sk->buf[sk->pos++];
+}
+
+void async_sock_ungetc(async_sock_t *sk)
+{
+	sk->pos -= (sk->pos > 0) ? 1 : 0;
+}
+#endif /* _WINDOWS */
+
+static int
+async_sock_fill(async_FILE *afd, char *sbuf, int n)
+{
+	int		nr = 0, r;
+
+	/* Binary record could be split between datagrams or segments.
+	 * */
+	while (nr < n && SDL_AtomicGet(&afd->flag_break) == 0) {
+
+		r = async_sock_read(afd->sk, (sbuf != NULL) ? sbuf + nr : NULL, n - nr);
+
+		if (r < 0)
+			break;
+
+		nr += r;
+	}
+
+	return nr;
+}
+
+static int
+async_fread(async_FILE *afd, char *sbuf, int n)
+{
+	if (afd->lz != NULL) {
+
+		return async_lz4_read(afd->lz, sbuf, n);
+	}
+	else if (afd->sk != NULL) {
+
+		n = async_sock_read(afd->sk, sbuf, n);
+
+		return (n > 0) ? n : 0;
+	}
+	else {
+		return (int) fread(sbuf, 1, n, afd->fd);
+	}
+}
+
+static int
+async_READ(async_FILE *afd)
+{
+	int		rp, wp, nw, r;
+
+	wp = SDL_AtomicGet(&afd->wp);
+
+	do {
+		rp = SDL_AtomicGet(&afd->rp);
+
+		nw = rp - (wp + 1);
+		nw += (nw < 0) ? afd->preload : 0;
+
+		if (nw >= afd->chunk) {
+
+			nw = afd->preload - wp;
+			nw = (nw > afd->chunk) ? afd->chunk : nw;
+
+			r = async_fread(afd, afd->stream + wp, nw);
+
+			if (r != 0) {
+
+				wp += r;
+				wp -= (wp >= afd->preload) ? afd->preload : 0;
+
+				SDL_AtomicSet(&afd->wp, wp);
+
+				async_notify(afd);
+
+				afd->waiting = 0;
+			}
+
+			if (r != nw) {
+
+				if (afd->lz != NULL) {
+
+					/* Compressed file does not grow.
+					 * */
+					break;
+				}
+				else if (afd->sk != NULL) {
+
+					/* Socket gives us what has arrived so far,
+					 * receive waits for the rest of it. Zero
+					 * timeout means we take what is there.
+					 * */
+					if (		afd->sk->closed != 0
+							|| (r == 0 && afd->timeout == 0))
+						break;
+				}
+				else if (feof(afd->fd) || ferror(afd->fd)) {
+
+					if (afd->waiting < afd->timeout) {
+
+						clearerr(afd->fd);
+
+						/* Poll the file to grow, stdio does
+						 * not give us a way to wait for it.
+						 * */
+						SDL_SemWaitTimeout(afd->sem_space, 10);
+
+						afd->waiting += 10;
+					}
+					else {
+						break;
+					}
+				}
+			}
+		}
+		else {
+			SDL_AtomicSet(&afd->full, 1);
+
+			if (SDL_AtomicGet(&afd->rp) == rp) {
+
+				SDL_SemWaitTimeout(afd->sem_space, 100);
+			}
+		}
+	}
+	while (SDL_AtomicGet(&afd->flag_break) == 0);
+
+	SDL_AtomicSet(&afd->flag_eof, 1);
+	SDL_AtomicSet(&afd->hungry, 1);
+
+	async_notify(afd);
+
+	SDL_AtomicSet(&afd->flag_exit, 1);
+
+	return 0;
+}
+
+static int
+async_STRIDE(async_FILE *afd)
+{
+	int		rp, wp, nw, r, len;
+
+	wp = SDL_AtomicGet(&afd->wp);
+
+	do {
+		rp = SDL_AtomicGet(&afd->rp);
+
+		nw = rp - (wp + 1);
+		nw += (nw < 0) ? afd->preload : 0;
+
+		if (nw >= afd->record) {
+
+			r = (afd->sk != NULL) ? async_sock_fill(afd, afd->line, afd->record)
+				: async_fread(afd, afd->line, afd->record);
+
+			if (r == afd->record) {
+
+				/* Record could wrap the ring.
+				 * */
+				len = afd->preload - wp;
+				len = (len > r) ? r : len;
+
+				memcpy(afd->stream + wp, afd->line, len);
+				memcpy(afd->stream, afd->line + len, r - len);
+
+				wp += r;
+				wp -= (wp >= afd->preload) ? afd->preload : 0;
+
+				SDL_AtomicSet(&afd->wp, wp);
+
+				async_notify(afd);
+
+				afd->waiting = 0;
+
+				/* Skip the records that we do not need. We may
+				 * go beyond the end of file that could grow.
+				 * */
+				if (afd->lz != NULL) {
+
+					async_lz4_read(afd->lz, NULL, (afd->stride - 1) * afd->record);
+				}
+				else if (afd->sk != NULL) {
+
+					async_sock_fill(afd, NULL, (afd->stride - 1) * afd->record);
+				}
+				else {
+#ifdef _WINDOWS
+					_fseeki64(afd->fd, (long long) (afd->stride - 1)
+							* afd->record, SEEK_CUR);
+#else /* _WINDOWS */
+					fseeko(afd->fd, (off_t) (afd->stride - 1)
+							* afd->record, SEEK_CUR);
+#endif
+				}
+			}
+			else {
+				if (afd->lz != NULL || afd->sk != NULL) {
+
+					break;
+				}
+
+				if (r > 0) {
+
+					/* Read the partial record again.
+					 * */
+					fseek(afd->fd, - (long) r, SEEK_CUR);
+				}
+
+				if (afd->waiting < afd->timeout) {
+
+					clearerr(afd->fd);
+
+					SDL_SemWaitTimeout(afd->sem_space, 10);
+
+					afd->waiting += 10;
+				}
+				else {
+					break;
+				}
+			}
+		}
+		else {
+			SDL_AtomicSet(&afd->full, 1);
+
+			if (SDL_AtomicGet(&afd->rp) == rp) {
+
+				SDL_SemWaitTimeout(afd->sem_space, 100);
+			}
+		}
+	}
+	while (SDL_AtomicGet(&afd->flag_break) == 0);
+
+	SDL_AtomicSet(&afd->flag_eof, 1);
+	SDL_AtomicSet(&afd->hungry, 1);
+
+	async_notify(afd);
+
+	SDL_AtomicSet(&afd->flag_exit, 1);
+
+	return 0;
+}
+
+static int
+async_space(async_FILE *afd, int wp)
+{
+	int		rp, wn;
+
+	wn = (wp < afd->row_max - 1) ? wp + 1 : 0;
+
+	do {
+		rp = SDL_AtomicGet(&afd->rp);
+
+		if (rp != wn)
+			break;
+
+		/* Publish what we have and wait for consumer.
+		 * */
+		SDL_AtomicSet(&afd->wp, wp);
+		SDL_AtomicSet(&afd->full, 1);
+
+		async_notify(afd);
+
+		if (SDL_AtomicGet(&afd->rp) == rp) {
+
+			SDL_SemWaitTimeout(afd->sem_space, 100);
+		}
+	}
+	while (SDL_AtomicGet(&afd->flag_break) == 0);
+
+	return (rp != wn) ? 1 : 0;
+}
+
+int async_seek(FILE *fd, long long pos)
+{
+#ifdef _WINDOWS
+	return _fseeki64(fd, pos, SEEK_SET);
+#else /* _WINDOWS */
+	return fseeko(fd, (off_t) pos, SEEK_SET);
+#endif
+}
+
+long long async_tell(FILE *fd)
+{
+#ifdef _WINDOWS
+	return _ftelli64(fd);
+#else /* _WINDOWS */
+	return (long long) ftello(fd);
+#endif
+}
+
+static int
+async_line(async_FILE *afd, int *wp, char *line, long long offset)
+{
+	char		*slot;
+	int		r;
+
+	if (async_space(afd, *wp) == 0)
+		return 0;
+
+	slot = afd->stream + *wp * afd->row_size;
+
+	/* Parse function returns negative value to end the stream.
+	 * */
+	r = afd->parse(afd->ctx, line, slot + ASYNC_ROW_HEAD);
+
+	if (r > 0) {
+
+		*(long long *) slot = offset;
+		*wp = (*wp < afd->row_max - 1) ? *wp + 1 : 0;
+	}
+
+	return (r < 0) ? 0 : 1;
+}
+
+static int
+async_PARSE(async_FILE *afd)
+{
+	long long	pos, line_pos = -1;
+	int		wp, r, len, nq = 0, skip, done = 0;
+	char		*s, *e, *q;
+
+	wp = SDL_AtomicGet(&afd->wp);
+
+	/* Skip the partial line that was left to the blocks.
+	 * */
+	skip = afd->tail_skip;
+
+	/* Row offsets are unknown if the stream is not seekable.
+	 * */
+	pos = (afd->lz == NULL && afd->sk == NULL) ? async_tell(afd->fd) : -1;
+
+	do {
+		r = async_fread(afd, afd->text, afd->chunk);
+
+		s = afd->text;
+		e = afd->text + r;
+
+		while (s < e) {
+
+			q = async_eol(s, e);
+
+			if (skip != 0) {
+
+				skip = (q < e) ? 0 : 1;
+			}
+			else if (q == e || nq != 0) {
+
+				/* Line crosses the chunk boundary so we
+				 * collect it in the line buffer.
+				 * */
+				len = (q - s < afd->line_max - 1 - nq)
+					? (int) (q - s) : afd->line_max - 1 - nq;
+
+				if (nq == 0) {
+
+					line_pos = (pos >= 0) ? pos + (s - afd->text) : -1;
+				}
+
+				memcpy(afd->line + nq, s, len);
+				nq += len;
+
+				if (q < e) {
+
+					afd->line[nq] = 0;
+					nq = 0;
+
+					if (async_line(afd, &wp, afd->line, line_pos) == 0) {
+
+						done = 1;
+						break;
+					}
+				}
+			}
+			else if (q != s) {
+
+				/* Parse the line right in the text buffer.
+				 * */
+				if (q - s > afd->line_max - 1) {
+
+					s[afd->line_max - 1] = 0;
+				}
+
+				*q = 0;
+
+				if (async_line(afd, &wp, s, (pos >= 0)
+							? pos + (s - afd->text) : -1) == 0) {
+
+					done = 1;
+					break;
+				}
+			}
+
+			s = q + 1;
+		}
+
+		pos += (pos >= 0) ? r : 0;
+
+		if (r != 0) {
+
+			SDL_AtomicSet(&afd->wp, wp);
+
+			async_notify(afd);
+
+			afd->waiting = 0;
+		}
+
+		if (done != 0)
+			break;
+
+		if (r != afd->chunk) {
+
+			if (afd->lz != NULL) {
+
+				break;
+			}
+			else if (afd->sk != NULL) {
+
+				if (		afd->sk->closed != 0
+						|| (r == 0 && afd->timeout == 0))
+					break;
+			}
+			else if (feof(afd->fd) || ferror(afd->fd)) {
+
+				if (afd->waiting < afd->timeout) {
+
+					clearerr(afd->fd);
+
+					SDL_SemWaitTimeout(afd->sem_space, 10);
+
+					afd->waiting += 10;
+				}
+				else {
+					break;
+				}
+			}
+		}
+	}
+	while (SDL_AtomicGet(&afd->flag_break) == 0);
+
+	SDL_AtomicSet(&afd->flag_eof, 1);
+	SDL_AtomicSet(&afd->hungry, 1);
+
+	async_notify(afd);
+
+	SDL_AtomicSet(&afd->flag_exit, 1);
+
+	return 0;
+}
+
+static int
+async_SAMPLE(async_FILE *afd)
+{
+	int		wp, N;
+	char		*s;
+
+	wp = SDL_AtomicGet(&afd->wp);
+
+	for (N = 0; N < afd->sample_N; ++N) {
+
+		if (SDL_AtomicGet(&afd->flag_break) != 0)
+			break;
+
+		async_seek(afd->fd, afd->sample[N]);
+
+		s = fgets(afd->line, afd->line_max, afd->fd);
+
+		if (s == NULL)
+			break;
+
+		*async_eol(s, s + strlen(s)) = 0;
+
+		if (async_line(afd, &wp, s, afd->sample[N]) == 0)
+			break;
+
+		SDL_AtomicSet(&afd->wp, wp);
+
+		async_notify(afd);
+	}
+
+	SDL_AtomicSet(&afd->flag_eof, 1);
+	SDL_AtomicSet(&afd->hungry, 1);
+
+	async_notify(afd);
+
+	SDL_AtomicSet(&afd->flag_exit, 1);
+
+	return 0;
+}
+
+static int
+async_block_row(async_FILE *afd, async_block_t *blk, char *line, long long offset)
+{
+	char		*slot;
+	int		r;
+
+	if (blk->row_N >= blk->row_max) {
+
+		blk->row_max = (blk->row_max < 1024) ? 1024 : blk->row_max * 2;
+		blk->rows = realloc(blk->rows, blk->row_max * afd->row_size);
+
+		if (blk->rows == NULL) {
+
+			ERROR("No memory allocated for async block\n");
+
+			blk->row_max = 0;
+			blk->row_N = 0;
+
+			return 0;
+		}
+	}
+
+	slot = blk->rows + blk->row_N * afd->row_size;
+
+	r = afd->parse(afd->ctx, line, slot + ASYNC_ROW_HEAD);
+
+	if (r > 0) {
+
+		*(long long *) slot = offset;
+		blk->row_N++;
+	}
+
+	return (r < 0) ? 0 : 1;
+}
+
+static void
+async_block_parse(async_worker_t *wk, async_block_t *blk, int kN)
+{
+	async_FILE	*afd = (async_FILE *) wk->afd;
+
+	long long	pos, end, line_pos = 0;
+	int		r, len, nq = 0, skip = 0, done = 0;
+	char		*s, *e, *q, c;
+
+	pos = afd->block_start + (long long) kN * ASYNC_BLOCK_SIZE;
+	end = pos + ASYNC_BLOCK_SIZE;
+
+	blk->row_N = 0;
+
+	/* Block owns the lines that begin inside it. We skip the line that
+	 * was started in the previous block and finish the last one.
+	 * */
+	if (kN != 0) {
+
+		async_seek(wk->fd, pos - 1);
+
+		c = (char) fgetc(wk->fd);
+		skip = (c != '\r' && c != '\n') ? 1 : 0;
+	}
+	else {
+		async_seek(wk->fd, pos);
+	}
+
+	do {
+		r = (afd->block_end - pos < ASYNC_TEXT_SIZE)
+			? (int) (afd->block_end - pos) : ASYNC_TEXT_SIZE;
+
+		r = (r > 0) ? fread(wk->text, 1, r, wk->fd) : 0;
+
+		s = wk->text;
+		e = wk->text + r;
+
+		while (s < e) {
+
+			q = async_eol(s, e);
+
+			if (skip != 0) {
+
+				skip = (q < e) ? 0 : 1;
+			}
+			else {
+				if (nq == 0 && pos + (s - wk->text) >= end) {
+
+					done = 1;
+					break;
+				}
+
+				if (q == e || nq != 0) {
+
+					len = (q - s < afd->line_max - 1 - nq)
+						? (int) (q - s) : afd->line_max - 1 - nq;
+
+					if (nq == 0) {
+
+						line_pos = pos + (s - wk->text);
+					}
+
+					memcpy(wk->line + nq, s, len);
+					nq += len;
+
+					if (q == e)
+						break;
+
+					wk->line[nq] = 0;
+					nq = 0;
+
+					if (		async_block_row(afd, blk, wk->line, line_pos) == 0
+							|| pos + (q - wk->text) >= end) {
+
+						done = 1;
+						break;
+					}
+				}
+				else if (q != s) {
+
+					if (q - s > afd->line_max - 1) {
+
+						s[afd->line_max - 1] = 0;
+					}
+
+					*q = 0;
+
+					if (		async_block_row(afd, blk, s, pos + (s - wk->text)) == 0
+							|| pos + (q - wk->text) >= end) {
+
+						done = 1;
+						break;
+					}
+				}
+			}
+
+			s = q + 1;
+		}
+
+		pos += r;
+	}
+	while (r > 0 && done == 0 && SDL_AtomicGet(&afd->flag_break) == 0);
+}
+
+static int
+async_CHUNK(async_worker_t *wk)
+{
+	async_FILE	*afd = (async_FILE *) wk->afd;
+	async_block_t	*blk;
+	int		kN;
+
+	do {
+		kN = SDL_AtomicAdd(&afd->block_next, 1);
+
+		if (kN >= afd->block_N)
+			break;
+
+		/* Wait for the slot of window to be consumed.
+		 * */
+		SDL_LockMutex(afd->mutex);
+
+		while (		kN >= SDL_AtomicGet(&afd->block_done) + afd->block_W
+				&& SDL_AtomicGet(&afd->flag_break) == 0) {
+
+			SDL_CondWaitTimeout(afd->cond, afd->mutex, 100);
+		}
+
+		SDL_UnlockMutex(afd->mutex);
+
+		if (SDL_AtomicGet(&afd->flag_break) != 0)
+			break;
+
+		blk = &afd->block[kN % afd->block_W];
+
+		async_block_parse(wk, blk, kN);
+
+		SDL_AtomicSet(&blk->ready, 1);
+
+		async_notify(afd);
+	}
+	while (SDL_AtomicGet(&afd->flag_break) == 0);
+
+	SDL_AtomicAdd(&afd->worker_live, -1);
+
+	return 0;
+}
+
+static void
+async_free(async_FILE *afd)
+{
+	int		N;
+
+	if (afd->worker != NULL) {
+
+		for (N = 0; N < afd->worker_N; ++N) {
+
+			if (afd->worker[N].fd != NULL) {
+
+				fclose(afd->worker[N].fd);
+			}
+
+			free(afd->worker[N].text);
+			free(afd->worker[N].line);
+		}
+	}
+
+	if (afd->block != NULL) {
+
+		for (N = 0; N < afd->block_W; ++N) {
+
+			free(afd->block[N].rows);
+		}
+	}
+
+	if (afd->cond != NULL) {
+
+		SDL_DestroyCond(afd->cond);
+	}
+
+	if (afd->mutex != NULL) {
+
+		SDL_DestroyMutex(afd->mutex);
+	}
+
+	if (afd->sem_space != NULL) {
+
+		SDL_DestroySemaphore(afd->sem_space);
+	}
+
+	free(afd->worker);
+	free(afd->block);
+	free(afd->sample);
+	free(afd->stream);
+	free(afd->text);
+	free(afd->line);
+	free(afd);
+}
+
+async_FILE *async_open(FILE *fd, async_lz4_t *lz, async_sock_t *sk,
+		int preload, int chunk, int timeout)
+{
+	async_FILE		*afd;
+
+	afd = calloc(1, sizeof(async_FILE));
+
+	if (afd == NULL) {
+
+		ERROR("No memory allocated for async_FILE\n");
+		return NULL;
+	}
+
+	afd->preload = preload;
+	afd->chunk = chunk;
+	afd->timeout = timeout;
 
-static int
-async_READ(async_FILE *afd)
+	afd->stream = (char *) malloc(afd->preload);
+
+	if (afd->stream == NULL) {
+
+		ERROR("No memory allocated for async preload\n");
+		async_free(afd);
+		return NULL;
+	}
+
+	afd->sem_space = SDL_CreateSemaphore(0);
+
+	if (afd->sem_space == NULL) {
+
+		ERROR("Unable to create semaphore: %s\n", SDL_GetError());
+		async_free(afd);
+		return NULL;
+	}
+
+	afd->fd = fd;
+	afd->lz = lz;
+	afd->sk = sk;
+	afd->thread = SDL_CreateThread((int (*) (void *)) &async_READ, "async_READ", afd);
+
+	return afd;
+}
+
+async_FILE *async_open_stride(FILE *fd, async_lz4_t *lz, async_sock_t *sk,
+		int preload, int timeout, int record, int stride)
 {
-	int		rp, wp, nw, r;
+	async_FILE		*afd;
 
-	wp = SDL_AtomicGet(&afd->wp);
+	afd = calloc(1, sizeof(async_FILE));
 
-	do {
-		rp = SDL_AtomicGet(&afd->rp);
+	if (afd == NULL) {
 
-		nw = rp - (wp + 1);
-		nw += (nw < 0) ? afd->preload : 0;
+		ERROR("No memory allocated for async_FILE\n");
+		return NULL;
+	}
 
-		if (nw >= afd->chunk) {
+	afd->preload = preload;
+	afd->chunk = record;
+	afd->timeout = timeout;
 
-			nw = afd->preload - wp;
-			nw = (nw > afd->chunk) ? afd->chunk : nw;
+	afd->record = record;
+	afd->stride = stride;
 
-			r = fread(afd->stream + wp, 1, nw, afd->fd);
+	afd->stream = (char *) malloc(afd->preload);
+	afd->line = (char *) malloc(afd->record);
 
-			if (r != 0) {
+	if (afd->stream == NULL || afd->line == NULL) {
 
-				wp += r;
-				wp -= (wp >= afd->preload) ? afd->preload : 0;
+		ERROR("No memory allocated for async preload\n");
+		async_free(afd);
+		return NULL;
+	}
 
-				SDL_AtomicSet(&afd->wp, wp);
+	afd->sem_space = SDL_CreateSemaphore(0);
 
-				afd->waiting = 0;
-			}
+	if (afd->sem_space == NULL) {
 
-			if (r != nw) {
+		ERROR("Unable to create semaphore: %s\n", SDL_GetError());
+		async_free(afd);
+		return NULL;
+	}
 
-				if (feof(afd->fd) || ferror(afd->fd)) {
+	afd->fd = fd;
+	afd->lz = lz;
+	afd->sk = sk;
+	afd->thread = SDL_CreateThread((int (*) (void *)) &async_STRIDE, "async_STRIDE", afd);
 
-					if (afd->waiting < afd->timeout) {
+	return afd;
+}
 
-						clearerr(afd->fd);
+async_FILE *async_open_parse(FILE *fd, async_lz4_t *lz, async_sock_t *sk,
+		int preload, int chunk, int timeout, async_parse_t parse, void *ctx,
+		int line_max, int row_size)
+{
+	async_FILE		*afd;
 
-						SDL_Delay(10);
+	afd = calloc(1, sizeof(async_FILE));
 
-						afd->waiting += 10;
-					}
-					else {
-						break;
-					}
-				}
-			}
-		}
-		else {
-			SDL_Delay(1);
-		}
+	if (afd == NULL) {
+
+		ERROR("No memory allocated for async_FILE\n");
+		return NULL;
 	}
-	while (SDL_AtomicGet(&afd->flag_break) == 0);
 
-	SDL_AtomicSet(&afd->flag_eof, 1);
+	afd->preload = preload;
+	afd->chunk = chunk;
+	afd->timeout = timeout;
 
-	return 0;
+	afd->parse = parse;
+	afd->ctx = ctx;
+
+	afd->line_max = line_max;
+	afd->row_size = ASYNC_ROW_HEAD + row_size;
+	afd->row_max = preload / afd->row_size;
+	afd->row_max = (afd->row_max < 64) ? 64 : afd->row_max;
+
+	afd->stream = (char *) malloc(afd->row_max * afd->row_size);
+	afd->text = (char *) malloc(afd->chunk);
+	afd->line = (char *) malloc(afd->line_max);
+
+	if (afd->stream == NULL || afd->text == NULL || afd->line == NULL) {
+
+		ERROR("No memory allocated for async preload\n");
+		async_free(afd);
+		return NULL;
+	}
+
+	afd->sem_space = SDL_CreateSemaphore(0);
+
+	if (afd->sem_space == NULL) {
+
+		ERROR("Unable to create semaphore: %s\n", SDL_GetError());
+		async_free(afd);
+		return NULL;
+	}
+
+	afd->fd = fd;
+	afd->lz = lz;
+	afd->sk = sk;
+	afd->thread = SDL_CreateThread((int (*) (void *)) &async_PARSE, "async_PARSE", afd);
+
+	return afd;
 }
 
-async_FILE *async_open(FILE *fd, int preload, int chunk, int timeout)
+async_FILE *async_open_chunked(FILE *fd, FILE **wfd, int worker_N, int preload, int chunk,
+		int timeout, async_parse_t parse, void *ctx, int line_max, int row_size)
 {
 	async_FILE		*afd;
+	async_worker_t		*wk;
+	int			N;
+	char			c;
 
 	afd = calloc(1, sizeof(async_FILE));
 
+	if (afd == NULL) {
+
+		ERROR("No memory allocated for async_FILE\n");
+
+		for (N = 0; N < worker_N; ++N) { fclose(wfd[N]); }
+
+		return NULL;
+	}
+
 	afd->preload = preload;
 	afd->chunk = chunk;
 	afd->timeout = timeout;
 
-	afd->stream = (char *) malloc(afd->preload);
+	afd->parse = parse;
+	afd->ctx = ctx;
 
-	if (afd->stream == NULL) {
+	afd->line_max = line_max;
+	afd->row_size = ASYNC_ROW_HEAD + row_size;
+	afd->row_max = preload / afd->row_size;
+	afd->row_max = (afd->row_max < 64) ? 64 : afd->row_max;
+
+	afd->stream = (char *) malloc(afd->row_max * afd->row_size);
+	afd->text = (char *) malloc(afd->chunk);
+	afd->line = (char *) malloc(afd->line_max);
+
+	afd->worker_N = worker_N;
+	afd->worker = calloc(worker_N, sizeof(async_worker_t));
+
+	if (afd->worker != NULL) {
+
+		/* Worker files are ours from here so they are closed
+		 * on any error.
+		 * */
+		for (N = 0; N < worker_N; ++N)
+			afd->worker[N].fd = wfd[N];
+	}
+	else {
+		for (N = 0; N < worker_N; ++N) { fclose(wfd[N]); }
+
+		afd->worker_N = 0;
+	}
+
+	afd->block_W = worker_N * 2;
+	afd->block = calloc(afd->block_W, sizeof(async_block_t));
+
+	if (		afd->stream == NULL || afd->text == NULL || afd->line == NULL
+			|| afd->worker == NULL || afd->block == NULL) {
+
+		ERROR("No memory allocated for async preload\n");
+		async_free(afd);
+		return NULL;
+	}
+
+	afd->sem_space = SDL_CreateSemaphore(0);
+	afd->mutex = SDL_CreateMutex();
+	afd->cond = SDL_CreateCond();
+
+	if (afd->sem_space == NULL || afd->mutex == NULL || afd->cond == NULL) {
+
+		ERROR("Unable to create semaphore: %s\n", SDL_GetError());
+		async_free(afd);
+		return NULL;
+	}
+
+	/* Blocks cover the file from the current position to the size that
+	 * it has now.
+	 * */
+	afd->block_start = async_tell(fd);
+
+	fseek(fd, 0L, SEEK_END);
+
+	afd->block_end = async_tell(fd);
+	afd->block_N = (int) ((afd->block_end - afd->block_start
+				+ ASYNC_BLOCK_SIZE - 1) / ASYNC_BLOCK_SIZE);
+
+	if (afd->block_N > 0) {
+
+		async_seek(fd, afd->block_end - 1);
+
+		c = (char) fgetc(fd);
+		afd->tail_skip = (c != '\r' && c != '\n') ? 1 : 0;
+	}
+
+	for (N = 0; N < worker_N; ++N) {
+
+		wk = &afd->worker[N];
+
+		wk->afd = afd;
+
+		wk->text = (char *) malloc(ASYNC_TEXT_SIZE);
+		wk->line = (char *) malloc(afd->line_max);
+
+		if (wk->text == NULL || wk->line == NULL) {
+
+			ERROR("No memory allocated for async worker\n");
+			async_free(afd);
+			return NULL;
+		}
+	}
+
+	afd->fd = fd;
+
+	SDL_AtomicSet(&afd->worker_live, worker_N);
+
+	for (N = 0; N < worker_N; ++N) {
+
+		wk = &afd->worker[N];
+		wk->thread = SDL_CreateThread((int (*) (void *)) &async_CHUNK, "async_CHUNK", wk);
+
+		if (wk->thread == NULL) {
+
+			SDL_AtomicAdd(&afd->worker_live, -1);
+		}
+	}
+
+	afd->thread = SDL_CreateThread((int (*) (void *)) &async_PARSE, "async_PARSE", afd);
+
+	return afd;
+}
+
+async_FILE *async_open_sample(FILE *fd, const long long *offset, int offset_N, int offset_step,
+		int preload, async_parse_t parse, void *ctx, int line_max, int row_size)
+{
+	async_FILE		*afd;
+	int			N;
+
+	afd = calloc(1, sizeof(async_FILE));
+
+	if (afd == NULL) {
+
+		ERROR("No memory allocated for async_FILE\n");
+		return NULL;
+	}
+
+	afd->preload = preload;
+
+	afd->parse = parse;
+	afd->ctx = ctx;
+
+	afd->line_max = line_max;
+	afd->row_size = ASYNC_ROW_HEAD + row_size;
+	afd->row_max = preload / afd->row_size;
+	afd->row_max = (afd->row_max < 64) ? 64 : afd->row_max;
+
+	afd->stream = (char *) malloc(afd->row_max * afd->row_size);
+	afd->line = (char *) malloc(afd->line_max);
+	afd->sample = (long long *) malloc(((offset_N > 0) ? offset_N : 1) * sizeof(long long));
+
+	if (afd->stream == NULL || afd->line == NULL || afd->sample == NULL) {
 
 		ERROR("No memory allocated for async preload\n");
+		async_free(afd);
+		return NULL;
+	}
+
+	/* We take one line of each step from the offsets given.
+	 * */
+	for (N = 0; N < offset_N; ++N) {
+
+		afd->sample[N] = offset[(long long) N * offset_step];
+	}
+
+	afd->sample_N = offset_N;
+
+	afd->sem_space = SDL_CreateSemaphore(0);
+
+	if (afd->sem_space == NULL) {
+
+		ERROR("Unable to create semaphore: %s\n", SDL_GetError());
+		async_free(afd);
 		return NULL;
 	}
 
 	afd->fd = fd;
-	afd->thread = SDL_CreateThread((int (*) (void *)) &async_READ, "async_READ", afd);
+	afd->thread = SDL_CreateThread((int (*) (void *)) &async_SAMPLE, "async_SAMPLE", afd);
 
 	return afd;
 }
 
 void async_close(async_FILE *afd)
 {
-	int		t = 0;
+	int		N, t = 0;
 
 	SDL_AtomicSet(&afd->flag_break, 1);
+	SDL_SemPost(afd->sem_space);
 	SDL_DetachThread(afd->thread);
 
+	for (N = 0; N < afd->worker_N; ++N) {
+
+		if (afd->worker[N].thread != NULL) {
+
+			SDL_DetachThread(afd->worker[N].thread);
+		}
+	}
+
+	if (afd->cond != NULL) {
+
+		SDL_LockMutex(afd->mutex);
+		SDL_CondBroadcast(afd->cond);
+		SDL_UnlockMutex(afd->mutex);
+	}
+
 	do {
-		SDL_Delay(10);
+		if (		SDL_AtomicGet(&afd->flag_exit) != 0
+				&& SDL_AtomicGet(&afd->worker_live) == 0) {
+
+			free(afd->ctx);
+
+			if (afd->lz != NULL) {
+
+				async_lz4_close(afd->lz);
+			}
+
+			if (afd->sk != NULL) {
 
-		if (SDL_AtomicGet(&afd->flag_eof) != 0) {
+				async_sock_close(afd->sk);
+			}
 
-			free(afd->stream);
-			free(afd);
+			async_free(afd);
 
 			break;
 		}
 
+		SDL_Delay(1);
+
 		t += 1;
 
-		if (t >= 200) {
+		if (t >= 2000) {
 
 			ERROR("Unable to terminate async_READ (memory leak)\n");
 			break;
@@ -167,6 +1797,11 @@ int async_read(async_FILE *afd, char *sbuf, int n)
 
 		SDL_AtomicSet(&afd->rp, rp);
 
+		if (SDL_AtomicGet(&afd->full) != 0) {
+
+			async_feed(afd);
+		}
+
 		return ASYNC_OK;
 	}
 	else if (SDL_AtomicGet(&afd->flag_eof) != 0) {
@@ -174,14 +1809,14 @@ int async_read(async_FILE *afd, char *sbuf, int n)
 		return ASYNC_END_OF_FILE;
 	}
 	else {
-		return ASYNC_NO_DATA_READY;
+		return async_starve(afd, wp);
 	}
 }
 
 int async_gets(async_FILE *afd, char *sbuf, int n)
 {
-	int		rp, wp, eol, nq;
-	char		c;
+	int		rp, wp, eol, nq, len;
+	char		*s, *e, *q;
 
 	rp = SDL_AtomicGet(&afd->rp);
 	wp = SDL_AtomicGet(&afd->wp);
@@ -195,23 +1830,38 @@ int async_gets(async_FILE *afd, char *sbuf, int n)
 			if (rp == wp)
 				break;
 
-			c = (int) afd->stream[rp];
+			s = afd->stream + rp;
 
-			if (c == '\r' || c == '\n') {
+			if (eol == 1) {
 
-				eol = (nq > 0) ? 1 : 0;
-			}
-			else if (eol == 1) {
+				if (*s != '\r' && *s != '\n')
+					break;
 
-				break;
+				rp = (rp < afd->preload - 1) ? rp + 1 : 0;
+				continue;
 			}
-			else if (nq < n - 1) {
 
-				*sbuf++ = (char) c;
-				nq++;
+			/* Scan the span that does not wrap the ring.
+			 * */
+			e = afd->stream + ((wp > rp) ? wp : afd->preload);
+			q = async_eol(s, e);
+
+			len = (q - s < n - 1 - nq) ? (int) (q - s) : n - 1 - nq;
+
+			memcpy(sbuf, s, len);
+
+			sbuf += len;
+			nq += len;
+
+			rp += (int) (q - s);
+
+			if (q < e) {
+
+				eol = (nq > 0) ? 1 : 0;
+				rp += 1;
 			}
 
-			rp = (rp < afd->preload - 1) ? rp + 1 : 0;
+			rp = (rp < afd->preload) ? rp : 0;
 		}
 		while (1);
 
@@ -223,12 +1873,17 @@ int async_gets(async_FILE *afd, char *sbuf, int n)
 
 			SDL_AtomicSet(&afd->rp, rp);
 
+			if (SDL_AtomicGet(&afd->full) != 0) {
+
+				async_feed(afd);
+			}
+
 			return ASYNC_OK;
 		}
 		else {
 			afd->cached = rp;
 
-			return ASYNC_NO_DATA_READY;
+			return async_starve(afd, wp);
 		}
 	}
 	else if (SDL_AtomicGet(&afd->flag_eof) != 0) {
@@ -236,7 +1891,93 @@ int async_gets(async_FILE *afd, char *sbuf, int n)
 		return ASYNC_END_OF_FILE;
 	}
 	else {
-		return ASYNC_NO_DATA_READY;
+		return async_starve(afd, wp);
+	}
+}
+
+int async_row(async_FILE *afd, void **row)
+{
+	async_block_t	*blk;
+	int		rp, wp, eof, kN;
+
+	while ((kN = SDL_AtomicGet(&afd->block_done)) < afd->block_N) {
+
+		blk = &afd->block[kN % afd->block_W];
+
+		if (SDL_AtomicGet(&blk->ready) == 0) {
+
+			SDL_AtomicSet(&afd->hungry, 1);
+
+			/* Block could be finished before we became hungry.
+			 * */
+			if (SDL_AtomicGet(&blk->ready) == 0) {
+
+				return ASYNC_NO_DATA_READY;
+			}
+		}
+
+		if (afd->block_pos < blk->row_N) {
+
+			*row = (void *) (blk->rows + afd->block_pos * afd->row_size
+					+ ASYNC_ROW_HEAD);
+
+			return ASYNC_OK;
+		}
+
+		SDL_AtomicSet(&blk->ready, 0);
+
+		afd->block_pos = 0;
+
+		SDL_LockMutex(afd->mutex);
+		SDL_AtomicAdd(&afd->block_done, 1);
+		SDL_CondBroadcast(afd->cond);
+		SDL_UnlockMutex(afd->mutex);
+	}
+
+	/* Check the end of file first as rows are published before.
+	 * */
+	eof = SDL_AtomicGet(&afd->flag_eof);
+
+	rp = SDL_AtomicGet(&afd->rp);
+	wp = SDL_AtomicGet(&afd->wp);
+
+	if (rp != wp) {
+
+		*row = (void *) (afd->stream + rp * afd->row_size + ASYNC_ROW_HEAD);
+
+		return ASYNC_OK;
+	}
+	else if (eof != 0) {
+
+		return ASYNC_END_OF_FILE;
+	}
+	else {
+		return async_starve(afd, wp);
+	}
+}
+
+void async_row_done(async_FILE *afd)
+{
+	int		rp;
+
+	if (SDL_AtomicGet(&afd->block_done) < afd->block_N) {
+
+		afd->block_pos++;
+		return ;
+	}
+
+	rp = SDL_AtomicGet(&afd->rp);
+	rp = (rp < afd->row_max - 1) ? rp + 1 : 0;
+
+	SDL_AtomicSet(&afd->rp, rp);
+
+	if (SDL_AtomicGet(&afd->full) != 0) {
+
+		async_feed(afd);
 	}
 }
 
+long long async_row_offset(async_FILE *afd, const void *row)
+{
+	return *(const long long *) ((const char *) row - ASYNC_ROW_HEAD);
+}
@@ -30,6 +30,80 @@ enum {
 	ASYNC_END_OF_FILE
 };
 
+#define ASYNC_BLOCK_SIZE		4194304
+#define ASYNC_TEXT_SIZE			65536
+#define ASYNC_WORKERS_MAX		16
+
+/* Each parsed row is preceded by file offset of its line.
+ * */
+#define ASYNC_ROW_HEAD			8
+
+/* Linked LZ4 blocks refer up to 64K back into decoded data.
+ * */
+#define ASYNC_LZ4_DICT			65536
+
+/* Socket receive buffer holds the largest datagram. Receive times out
+ * so that reader could see the break flag.
+ * */
+#define ASYNC_SOCK_SIZE			65536
+#define ASYNC_SOCK_WAIT			100
+
+typedef int (* async_parse_t) (void *ctx, char *line, void *row);
+
+typedef struct {
+
+	FILE		*fd;
+
+	int		frame;
+	int		flag;
+	int		block_max;
+
+	char		*src;
+	char		*dst;
+	int		hist;
+	int		pos;
+	int		len;
+}
+async_lz4_t;
+
+typedef struct {
+
+	int		sock;
+	int		type;
+	int		closed;
+
+	/* Datagram is taken as a whole number of records or lines so
+	 * that a lost datagram does not shift the next ones.
+	 * */
+	int		record;
+
+	char		*buf;
+	int		pos;
+	int		len;
+}
+async_sock_t;
+
+typedef struct {
+
+	void		*afd;
+	FILE		*fd;
+	SDL_Thread	*thread;
+
+	char		*text;
+	char		*line;
+}
+async_worker_t;
+
+typedef struct {
+
+	char		*rows;
+	int		row_N;
+	int		row_max;
+
+	SDL_atomic_t	ready;
+}
+async_block_t;
+
 typedef struct {
 
 	FILE		*fd;
@@ -45,16 +119,111 @@ typedef struct {
 	SDL_atomic_t	rp;
 	SDL_atomic_t	wp;
 
+	/* Reader thread sleeps on semaphore while stream is full. Reader
+	 * posts an event when consumer has run out of data.
+	 * */
+	SDL_sem		*sem_space;
+	SDL_atomic_t	full;
+	SDL_atomic_t	hungry;
+
 	SDL_atomic_t	flag_eof;
 	SDL_atomic_t	flag_break;
+	SDL_atomic_t	flag_exit;
+
+	/* Text lines are parsed on the reader thread when parse function
+	 * is given. Then stream holds the ring of parsed rows.
+	 * */
+	async_parse_t	parse;
+	void		*ctx;
+
+	char		*text;
+	char		*line;
+	int		line_max;
+	int		row_size;
+	int		row_max;
+
+	/* Regular file is split into blocks that are parsed by workers
+	 * concurrently and consumed in order. Then the reader thread takes
+	 * the rest of file that could grow after open.
+	 * */
+	async_worker_t	*worker;
+	int		worker_N;
+	SDL_atomic_t	worker_live;
+
+	async_block_t	*block;
+	int		block_N;
+	int		block_W;
+	int		block_pos;
+
+	SDL_atomic_t	block_next;
+	SDL_atomic_t	block_done;
+
+	long long	block_start;
+	long long	block_end;
+
+	SDL_mutex	*mutex;
+	SDL_cond	*cond;
+
+	int		tail_skip;
+
+	/* Binary reader takes one record of each stride and seeks over the
+	 * rest of them.
+	 * */
+	int		record;
+	int		stride;
+
+	/* Text reader seeks to each of the sampled line offsets.
+	 * */
+	long long	*sample;
+	int		sample_N;
+
+	/* Compressed file is decoded on the reader thread.
+	 * */
+	async_lz4_t	*lz;
+
+	/* Socket is received on the reader thread.
+	 * */
+	async_sock_t	*sk;
 }
 async_FILE;
 
-async_FILE *async_open(FILE *fd, int preload, int chunk, int timeout);
+Uint32 async_init();
+
+async_FILE *async_open(FILE *fd, async_lz4_t *lz, async_sock_t *sk,
+		int preload, int chunk, int timeout);
+async_FILE *async_open_stride(FILE *fd, async_lz4_t *lz, async_sock_t *sk,
+		int preload, int timeout, int record, int stride);
+async_FILE *async_open_parse(FILE *fd, async_lz4_t *lz, async_sock_t *sk,
+		int preload, int chunk, int timeout, async_parse_t parse, void *ctx,
+		int line_max, int row_size);
+async_FILE *async_open_chunked(FILE *fd, FILE **wfd, int worker_N, int preload, int chunk,
+		int timeout, async_parse_t parse, void *ctx, int line_max, int row_size);
+async_FILE *async_open_sample(FILE *fd, const long long *offset, int offset_N, int offset_step,
+		int preload, async_parse_t parse, void *ctx, int line_max, int row_size);
 void async_close(async_FILE *afd);
 
+int async_seek(FILE *fd, long long pos);
+long long async_tell(FILE *fd);
+
+async_lz4_t *async_lz4_open(FILE *fd);
+void async_lz4_close(async_lz4_t *lz);
+int async_lz4_read(async_lz4_t *lz, char *sbuf, int n);
+int async_lz4_getc(async_lz4_t *lz);
+void async_lz4_ungetc(async_lz4_t *lz);
+
+int async_sock_name(const char *name);
+async_sock_t *async_sock_open(const char *name, int rcvbuf);
+void async_sock_close(async_sock_t *sk);
+int async_sock_read(async_sock_t *sk, char *sbuf, int n);
+int async_sock_getc(async_sock_t *sk);
+void async_sock_ungetc(async_sock_t *sk);
+
 int async_read(async_FILE *afd, char *sbuf, int n);
 int async_gets(async_FILE *afd, char *sbuf, int n);
 
+int async_row(async_FILE *afd, void **row);
+void async_row_done(async_FILE *afd);
+long long async_row_offset(async_FILE *afd, const void *row);
+
 #endif /* _H_ASYNC_ */
 
@@ -0,0 +1,191 @@
+/*
+   Graph Plotter for numerical data analysis.
+   Copyright (C) 2022 Roman Belov <romblv@gmail.com>
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Parse throughput of the text reader. We include read.c to reach its
+ * static parsers so this is built apart from gp with "make bench".
+ * */
+
+#include "read.c"
+
+#define BENCH_ROWS_DEFAULT	1000000
+#define BENCH_PASS_MIN		3
+
+static char *
+benchGenerate(int rN, long long *len)
+{
+	char		*text, *s;
+	int		N;
+
+	text = malloc((size_t) rN * 80 + 1);
+
+	if (text == NULL) {
+
+		ERROR("No memory allocated for bench text\n");
+		return NULL;
+	}
+
+	s = text;
+
+	/* Typical columns of a telemetry log.
+	 * */
+	for (N = 0; N < rN; ++N) {
+
+		s += sprintf(s, "%.6f %i %.4f %.5e %.3f\n", N * 1e-4, N % 4096,
+				(N % 1000) * 0.173 - 80., (N % 777) * 3.3e-7,
+				- (double) (N % 997) / 7.);
+	}
+
+	*len = s - text;
+
+	return text;
+}
+
+static char *
+benchLoad(const char *file, long long *len)
+{
+	FILE		*fd;
+	char		*text;
+	ulen_t		sF;
+
+	sF = FILE_GetSize(file);
+	fd = unified_fopen(file, "rb");
+
+	if (fd == NULL || sF == 0) {
+
+		ERROR("fopen(\"%s\"): %s\n", file, strerror(errno));
+		return NULL;
+	}
+
+	text = malloc(sF + 1);
+
+	if (text == NULL || fread(text, 1, sF, fd) != sF) {
+
+		ERROR("Unable to read file \"%s\"\n", file);
+		fclose(fd);
+		free(text);
+		return NULL;
+	}
+
+	fclose(fd);
+
+	*len = (long long) sF;
+
+	return text;
+}
+
+static double
+benchTime()
+{
+	return (double) SDL_GetPerformanceCounter()
+		/ (double) SDL_GetPerformanceFrequency();
+}
+
+static void
+benchReport(const char *name, long long len, double sum, double t)
+{
+	printf("%-12s %8.1f MB/s   (sum %.6e)\n", name, len / t / 1e+6, sum);
+}
+
+int main(int argc, char *argv[])
+{
+	read_t		*rd;
+	fval_t		row[READ_COLUMN_MAX];
+
+	char		*text, *line, *s, *r, *e;
+	long long	len;
+	double		val, sum, tS, tE;
+	int		N, cN, pass;
+
+	rd = readAlloc(NULL);
+
+	text = (argc > 1) ? benchLoad(argv[1], &len)
+		: benchGenerate(BENCH_ROWS_DEFAULT, &len);
+
+	if (text == NULL)
+		return 1;
+
+	/* Lines are terminated in place the same way the reader does.
+	 * */
+	for (s = text, e = text + len; s < e; ++s) {
+
+		if (*s == '\n' || *s == '\r') { *s = 0; }
+	}
+
+	*e = 0;
+
+	printf("%.1f MB of text\n", len / 1e+6);
+
+	for (pass = 0; pass < 3; ++pass) {
+
+		sum = 0.;
+		N = 0;
+
+		tS = benchTime();
+
+		do {
+			for (line = text; line < e; line += strlen(line) + 1) {
+
+				if (pass == 2) {
+
+					cN = TEXT_GetRow(rd, 0, line, row, NULL, 0);
+					sum += (cN > 0 && row[0] == row[0]) ? row[0] : 0.;
+
+					continue;
+				}
+
+				for (s = line; *s != 0; s = (*s != 0) ? s + 1 : s) {
+
+					if (rd->mk_text.map[(unsigned char) *s] != 0)
+						continue;
+
+					/* Library conversion is a reference.
+					 * */
+					if (pass == 0) {
+
+						val = strtod(s, &r);
+						r = (r != s) ? r : NULL;
+					}
+					else {
+						r = stod(&rd->mk_text, &val, s);
+					}
+
+					if (r != NULL) {
+
+						sum += val;
+						s = r;
+					}
+					else {
+						while (rd->mk_text.map[(unsigned char) *s] == 0) { s++; }
+					}
+				}
+			}
+
+			N += 1;
+			tE = benchTime();
+		}
+		while (N < BENCH_PASS_MIN || tE - tS < 1.);
+
+		benchReport((pass == 0) ? "strtod" : (pass == 1) ? "stod"
+				: "TEXT_GetRow", len * N, sum / N, tE - tS);
+	}
+
+	free(text);
+	free(rd);
+
+	return 0;
+}
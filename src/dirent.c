@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 
 #include "dirent.h"
 
@@ -143,7 +144,79 @@ int fstatsize(const char *file, unsigned long long *sb)
 	return 0;
 }
 
+int fstatmtime(const char *file, unsigned long long *mt)
+{
+	wchar_t				wfile[DIRENT_PATH_MAX];
+	WIN32_FILE_ATTRIBUTE_DATA	fad;
+
+	MultiByteToWideChar(CP_UTF8, 0, file, -1, wfile, DIRENT_PATH_MAX);
+
+	if (GetFileAttributesExW(wfile, GetFileExInfoStandard, &fad) == 0) {
+
+		return -1;
+	}
+
+	*mt = ((unsigned long long) fad.ftLastWriteTime.dwHighDateTime << 32)
+		| (unsigned long long) fad.ftLastWriteTime.dwLowDateTime;
+
+	return 0;
+}
+
+void *fmmap(const char *file, unsigned long long *sb)
+{
+	wchar_t			wfile[DIRENT_PATH_MAX];
+	HANDLE			hFile, hMap;
+	LARGE_INTEGER		nSize;
+	void			*map = NULL;
+
+	MultiByteToWideChar(CP_UTF8, 0, file, -1, wfile, DIRENT_PATH_MAX);
+
+	hFile = CreateFileW(wfile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+			NULL, OPEN_EXISTING, 0, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE) {
+
+		return NULL;
+	}
+
+	if (GetFileSizeEx(hFile, &nSize) != 0 && nSize.QuadPart > 0) {
+
+		hMap = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (hMap != NULL) {
+
+			/* View keeps the mapping alive after handles are closed.
+			 * */
+			map = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+
+			CloseHandle(hMap);
+		}
+
+		*sb = nSize.QuadPart;
+	}
+
+	CloseHandle(hFile);
+
+	return map;
+}
+
+void fmunmap(void *map, unsigned long long sb)
+{
+	UnmapViewOfFile(map);
+}
+
+FILE *fshmopen(const char *name, void **map, unsigned long long *sb)
+{
+	errno = ENOSYS;
+
+	return NULL;
+}
+
 #else /* _WINDOWS */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
 int fstatsize(const char *file, unsigned long long *sb)
 {
 	struct stat		sbs;
@@ -158,5 +231,100 @@ int fstatsize(const char *file, unsigned long long *sb)
 
 	return rc;
 }
+
+int fstatmtime(const char *file, unsigned long long *mt)
+{
+	struct stat		sbs;
+	int			rc;
+
+	rc = stat(file, &sbs);
+
+	if (rc == 0) {
+
+		*mt = (unsigned long long) sbs.st_mtime * 1000000000ULL
+			+ (unsigned long long) sbs.st_mtim.tv_nsec;
+	}
+
+	return rc;
+}
+
+void *fmmap(const char *file, unsigned long long *sb)
+{
+	struct stat		sbs;
+	void			*map = NULL;
+	int			fd;
+
+	fd = open(file, O_RDONLY);
+
+	if (fd < 0) {
+
+		return NULL;
+	}
+
+	if (fstat(fd, &sbs) == 0 && sbs.st_size > 0) {
+
+		map = mmap(NULL, sbs.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		map = (map != MAP_FAILED) ? map : NULL;
+
+		*sb = sbs.st_size;
+	}
+
+	close(fd);
+
+	return map;
+}
+
+void fmunmap(void *map, unsigned long long sb)
+{
+	munmap(map, sb);
+}
+
+FILE *fshmopen(const char *name, void **map, unsigned long long *sb)
+{
+	struct stat		sbs;
+	FILE			*fd = NULL;
+	int			sd;
+
+	*map = NULL;
+
+	sd = shm_open(name, O_RDWR, 0);
+
+	if (sd < 0) {
+
+		return NULL;
+	}
+
+	if (fstat(sd, &sbs) == 0 && sbs.st_size > 0) {
+
+		*map = mmap(NULL, sbs.st_size, PROT_READ | PROT_WRITE,
+				MAP_SHARED, sd, 0);
+
+		*map = (*map != MAP_FAILED) ? *map : NULL;
+		*sb = sbs.st_size;
+	}
+	else {
+		errno = EINVAL;
+	}
+
+	if (*map != NULL) {
+
+		/* We keep the object in FILE just to close it later.
+		 * */
+		fd = fdopen(sd, "rb");
+
+		if (fd == NULL) {
+
+			munmap(*map, *sb);
+			*map = NULL;
+		}
+	}
+
+	if (fd == NULL) {
+
+		close(sd);
+	}
+
+	return fd;
+}
 #endif /* _WINDOWS */
 
@@ -19,6 +19,8 @@
 #ifndef _H_DIRENT_
 #define _H_DIRENT_
 
+#include <stdio.h>
+
 #ifdef _WINDOWS
 struct DIR_sb;
 typedef struct DIR_sb DIR;
@@ -48,6 +50,12 @@ void rewinddir(DIR *d);
 #endif /* _WINDOWS */
 
 int fstatsize(const char *file, unsigned long long *sb);
+int fstatmtime(const char *file, unsigned long long *mt);
+
+void *fmmap(const char *file, unsigned long long *sb);
+void fmunmap(void *map, unsigned long long sb);
+
+FILE *fshmopen(const char *name, void **map, unsigned long long *sb);
 
 #endif /* _H_DIRENT_ */
 
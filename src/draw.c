@@ -17,8 +17,13 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* __SSE2__ */
+
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
@@ -71,45 +76,109 @@ void drawClearSurface(draw_t *dw, SDL_Surface *surface, colType_t col)
 	drawDashReset(dw);
 }
 
-void drawClearCanvas(draw_t *dw)
+static void
+drawTileClear(draw_t *dw, Uint8 *pixmap, Uint8 *tile, int bpp)
+{
+	int			tx, ty, xs, xe, ys, ye, y, yspan;
+
+	yspan = dw->pixmap.yspan * bpp;
+
+	for (ty = 0; ty < dw->tile.h; ++ty) {
+
+		ys = ty << DRAW_TILE_SHIFT;
+		ye = ys + (1 << DRAW_TILE_SHIFT);
+		ye = (ye > dw->pixmap.h) ? dw->pixmap.h : ye;
+
+		for (tx = 0; tx < dw->tile.w; ++tx) {
+
+			if (tile[tx] == 0)
+				continue;
+
+			xs = tx << DRAW_TILE_SHIFT;
+
+			while (tx + 1 < dw->tile.w && tile[tx + 1] != 0)
+				++tx;
+
+			xe = (tx + 1) << DRAW_TILE_SHIFT;
+			xe = (xe > dw->pixmap.yspan) ? dw->pixmap.yspan : xe;
+
+			for (y = ys; y < ye; ++y) {
+
+				memset(pixmap + y * yspan + xs * bpp, 0, (xe - xs) * bpp);
+			}
+		}
+
+		memset(tile, 0, dw->tile.w);
+
+		tile += dw->tile.w;
+	}
+}
+
+static void
+drawTileMark(draw_t *dw, Uint8 *tile, const clipBox_t *lcb)
 {
-	int			len;
+	int			txs, tys, txe, tye, ty;
+
+	if (lcb->min_x > lcb->max_x || lcb->min_y > lcb->max_y)
+		return ;
+
+	txs = lcb->min_x >> DRAW_TILE_SHIFT;
+	tys = lcb->min_y >> DRAW_TILE_SHIFT;
+	txe = lcb->max_x >> DRAW_TILE_SHIFT;
+	tye = lcb->max_y >> DRAW_TILE_SHIFT;
+
+	txs = (txs < 0) ? 0 : txs;
+	tys = (tys < 0) ? 0 : tys;
+	txe = (txe > dw->tile.w - 1) ? dw->tile.w - 1 : txe;
+	tye = (tye > dw->tile.h - 1) ? dw->tile.h - 1 : tye;
 
-	len = dw->pixmap.yspan * dw->pixmap.h;
+	for (ty = tys; ty <= tye; ++ty) {
+
+		memset(tile + ty * dw->tile.w + txs, 1, txe - txs + 1);
+	}
+}
+
+void drawClearCanvas(draw_t *dw)
+{
+	int			bpp = 1;
 
 	if (dw->antialiasing == DRAW_4X_MSAA) {
 
-		len *= 2;
+		bpp = 2;
 	}
 	else if (dw->antialiasing == DRAW_8X_MSAA) {
 
-		len *= 4;
+		bpp = 4;
 	}
 
-	memset(dw->pixmap.canvas, 0, len);
+	drawTileClear(dw, (Uint8 *) dw->pixmap.canvas, dw->tile.canvas, bpp);
 }
 
 void drawClearTrial(draw_t *dw)
 {
-	int			len;
-
-	len = dw->pixmap.yspan * dw->pixmap.h;
+	int			bpp = 1;
 
 	if (dw->antialiasing != DRAW_SOLID) {
 
-		len *= 2;
+		bpp = 2;
 	}
 
-	memset(dw->pixmap.trial, 0, len);
+	drawTileClear(dw, (Uint8 *) dw->pixmap.trial, dw->tile.trial, bpp);
 }
 
 void drawPixmapAlloc(draw_t *dw, SDL_Surface *surface)
 {
-	int		w, h, len;
+	int		w, h, len, tw, th, dirty = 0;
 
 	w = surface->w;
 	h = surface->h;
 
+	if (		dw->pixmap.w != w
+			|| dw->pixmap.h != h) {
+
+		dirty = 1;
+	}
+
 	dw->pixmap.w = w;
 	dw->pixmap.h = h;
 
@@ -151,6 +220,47 @@ void drawPixmapAlloc(draw_t *dw, SDL_Surface *surface)
 
 			ERROR("Unable to allocate memory of the trial pixmap\n");
 		}
+
+		dirty = 1;
+	}
+
+	tw = (w + (1 << DRAW_TILE_SHIFT) - 1) >> DRAW_TILE_SHIFT;
+	th = (h + (1 << DRAW_TILE_SHIFT) - 1) >> DRAW_TILE_SHIFT;
+
+	if (dw->tile.len < tw * th) {
+
+		if (dw->tile.len != 0) {
+
+			free(dw->tile.canvas);
+			free(dw->tile.trial);
+		}
+
+		dw->tile.len = tw * th;
+		dw->tile.canvas = (Uint8 *) malloc(dw->tile.len);
+		dw->tile.trial = (Uint8 *) malloc(dw->tile.len);
+
+		if (dw->tile.canvas == NULL || dw->tile.trial == NULL) {
+
+			ERROR("Unable to allocate memory of the tile bitmap\n");
+		}
+	}
+
+	if (dw->tile.antialiasing != dw->antialiasing) {
+
+		dirty = 1;
+	}
+
+	if (dirty != 0) {
+
+		/* Pixmap layout was changed so we do not know where the
+		 * garbage is. Mark the whole pixmap to be cleared.
+		 * */
+		dw->tile.w = tw;
+		dw->tile.h = th;
+		dw->tile.antialiasing = dw->antialiasing;
+
+		memset(dw->tile.canvas, 1, tw * th);
+		memset(dw->tile.trial, 1, tw * th);
 	}
 }
 
@@ -161,6 +271,12 @@ void drawPixmapClean(draw_t *dw)
 		free(dw->pixmap.canvas);
 		free(dw->pixmap.trial);
 	}
+
+	if (dw->tile.len != 0) {
+
+		free(dw->tile.canvas);
+		free(dw->tile.trial);
+	}
 }
 
 static int
@@ -568,6 +684,8 @@ void drawLineCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb, double fxs,
 	lcb.max_x = (lcb.max_x > cb->max_x) ? cb->max_x : lcb.max_x;
 	lcb.max_y = (lcb.max_y > cb->max_y) ? cb->max_y : lcb.max_y;
 
+	drawTileMark(dw, dw->tile.canvas, &lcb);
+
 	l = (xs - xe) * (xs - xe) + (ys - ye) * (ys - ye);
 	d = (int) sqrtf((float) l);
 
@@ -1250,6 +1368,8 @@ void drawDashCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb, double fxs,
 	lcb.max_x = (lcb.max_x > cb->max_x) ? cb->max_x : lcb.max_x;
 	lcb.max_y = (lcb.max_y > cb->max_y) ? cb->max_y : lcb.max_y;
 
+	drawTileMark(dw, dw->tile.canvas, &lcb);
+
 	e = (xs - xe) * (xs - xe) + (ys - ye) * (ys - ye);
 	d = (int) sqrtf((float) e);
 
@@ -1673,6 +1793,30 @@ int drawLineTrial(draw_t *dw, clipBox_t *cb, double fxs, double fys,
 	lcb.max_x = (lcb.max_x > cb->max_x) ? cb->max_x : lcb.max_x;
 	lcb.max_y = (lcb.max_y > cb->max_y) ? cb->max_y : lcb.max_y;
 
+	if (dw->antialiasing == DRAW_4X_MSAA) {
+
+		clipBox_t		tcb;
+
+		/* We write 8-bit trial here but it is cleared as 16-bit
+		 * pixmap so each row falls into the left or right half.
+		 * */
+		tcb.min_y = lcb.min_y / 2;
+		tcb.max_y = lcb.max_y / 2;
+
+		tcb.min_x = lcb.min_x / 2;
+		tcb.max_x = lcb.max_x / 2;
+
+		drawTileMark(dw, dw->tile.trial, &tcb);
+
+		tcb.min_x = (dw->pixmap.yspan + lcb.min_x) / 2;
+		tcb.max_x = (dw->pixmap.yspan + lcb.max_x) / 2;
+
+		drawTileMark(dw, dw->tile.trial, &tcb);
+	}
+	else {
+		drawTileMark(dw, dw->tile.trial, &lcb);
+	}
+
 	l = (xs - xe) * (xs - xe) + (ys - ye) * (ys - ye);
 	d = (int) sqrtf((float) l);
 
@@ -1966,27 +2110,14 @@ int drawLineTrial(draw_t *dw, clipBox_t *cb, double fxs, double fys,
 	return fill;
 }
 
-void drawText(draw_t *dw, SDL_Surface *surface, TTF_Font *font, int xs, int ys,
-		const char *text, int flags, colType_t col)
+static SDL_Surface *
+drawTextRender(draw_t *dw, TTF_Font *font, const char *text, int flags, colType_t col)
 {
-	svg_t			*g = (svg_t *) surface->userdata;
 	SDL_Surface		*textSurface, *surfaceCopy;
-	SDL_Rect		textRect;
 	SDL_Color		textColor;
 
 	int			pitch, i, j;
 
-	if (font == NULL)
-		return ;
-
-	if (text[0] == 0)
-		return ;
-
-	if (g != NULL) {
-
-		svgDrawText(g, xs, ys, text, (svgCol_t) col, flags);
-	}
-
 	textColor.a = 0;
 	textColor.r = (col & 0x00FF0000UL) >> 16;
 	textColor.g = (col & 0x0000FF00UL) >> 8;
@@ -2001,7 +2132,7 @@ void drawText(draw_t *dw, SDL_Surface *surface, TTF_Font *font, int xs, int ys,
 	}
 
 	if (textSurface == NULL)
-		return ;
+		return NULL;
 
 	if (flags & TEXT_VERTICAL) {
 
@@ -2066,6 +2197,132 @@ void drawText(draw_t *dw, SDL_Surface *surface, TTF_Font *font, int xs, int ys,
 		textSurface = surfaceCopy;
 	}
 
+	return textSurface;
+}
+
+void drawTextCacheClean(draw_t *dw)
+{
+	textCache_t		*tc;
+	int			N;
+
+	for (N = 0; N < DRAW_TEXT_CACHE_MAX; ++N) {
+
+		tc = &dw->text_cache[N];
+
+		if (tc->surface != NULL) {
+
+			SDL_FreeSurface(tc->surface);
+		}
+
+		tc->surface = NULL;
+	}
+
+	dw->text_stamp = 0;
+}
+
+static SDL_Surface *
+drawTextCached(draw_t *dw, TTF_Font *font, const char *text, int flags, colType_t col)
+{
+	textCache_t		*tc, *lru;
+	Uint32			hash = 2166136261U;
+	int			N, len;
+
+	for (len = 0; text[len] != 0; ++len) {
+
+		hash = (hash ^ (Uint8) text[len]) * 16777619U;
+	}
+
+	if (len >= DRAW_TEXT_CACHE_LEN)
+		return NULL;
+
+	flags = (flags & TEXT_VERTICAL) | ((dw->solidfont != 0) ? 0x100 : 0);
+
+	dw->text_stamp++;
+
+	lru = &dw->text_cache[0];
+
+	for (N = 0; N < DRAW_TEXT_CACHE_MAX; ++N) {
+
+		tc = &dw->text_cache[N];
+
+		if (tc->surface == NULL) {
+
+			lru = tc;
+			continue;
+		}
+
+		if (		   tc->hash == hash
+				&& tc->font == font
+				&& tc->col == col
+				&& tc->flags == flags
+				&& strcmp(tc->text, text) == 0) {
+
+			tc->stamp = dw->text_stamp;
+
+			return tc->surface;
+		}
+
+		if (		lru->surface != NULL
+				&& dw->text_stamp - tc->stamp > dw->text_stamp - lru->stamp) {
+
+			lru = tc;
+		}
+	}
+
+	/* Evict the least recently used surface.
+	 * */
+	if (lru->surface != NULL) {
+
+		SDL_FreeSurface(lru->surface);
+
+		lru->surface = NULL;
+	}
+
+	lru->surface = drawTextRender(dw, font, text, flags, col);
+
+	if (lru->surface != NULL) {
+
+		lru->font = font;
+		lru->col = col;
+		lru->flags = flags;
+		lru->hash = hash;
+		lru->stamp = dw->text_stamp;
+
+		memcpy(lru->text, text, len + 1);
+	}
+
+	return lru->surface;
+}
+
+void drawText(draw_t *dw, SDL_Surface *surface, TTF_Font *font, int xs, int ys,
+		const char *text, int flags, colType_t col)
+{
+	svg_t			*g = (svg_t *) surface->userdata;
+	SDL_Surface		*textSurface, *textUncached = NULL;
+	SDL_Rect		textRect;
+
+	if (font == NULL)
+		return ;
+
+	if (text[0] == 0)
+		return ;
+
+	if (g != NULL) {
+
+		svgDrawText(g, xs, ys, text, (svgCol_t) col, flags);
+	}
+
+	textSurface = drawTextCached(dw, font, text, flags, col);
+
+	if (textSurface == NULL) {
+
+		textUncached = drawTextRender(dw, font, text, flags, col);
+		textSurface = textUncached;
+	}
+
+	if (textSurface == NULL)
+		return ;
+
 	textRect.w = textSurface->w;
 	textRect.h = textSurface->h;
 	textRect.x = xs;
@@ -2082,7 +2339,64 @@ void drawText(draw_t *dw, SDL_Surface *surface, TTF_Font *font, int xs, int ys,
 	}
 
 	SDL_BlitSurface(textSurface, NULL, surface, &textRect);
-	SDL_FreeSurface(textSurface);
+
+	if (textUncached != NULL) {
+
+		SDL_FreeSurface(textUncached);
+	}
+}
+
+void drawOverlay(SDL_Surface *surface, SDL_Surface *black, SDL_Surface *white,
+		clipBox_t *cb)
+{
+	colType_t		*pixels, *pb, *pw;
+	colType_t		b, w, d;
+
+	int			pitch, x, y, sh, kb, kw, kd;
+
+	pitch = surface->pitch / 4;
+
+	for (y = cb->min_y; y <= cb->max_y; ++y) {
+
+		pixels = (colType_t *) surface->pixels + pitch * y;
+		pb = (colType_t *) black->pixels + pitch * y;
+		pw = (colType_t *) white->pixels + pitch * y;
+
+		for (x = cb->min_x; x <= cb->max_x; ++x) {
+
+			b = pb[x] & 0xFFFFFFU;
+			w = pw[x] & 0xFFFFFFU;
+
+			if (b == 0U && w == 0xFFFFFFU)
+				continue;
+
+			if (b == w) {
+
+				pixels[x] = b;
+				continue;
+			}
+
+			/* Drawing blends each channel linearly so the
+			 * difference over white and black is the share of
+			 * background that is left.
+			 * */
+			d = 0U;
+
+			for (sh = 0; sh < 24; sh += 8) {
+
+				kb = (b >> sh) & 0xFFU;
+				kw = (w >> sh) & 0xFFU;
+				kd = kb + (((pixels[x] >> sh) & 0xFFU)
+						* (kw - kb) + 127) / 255;
+
+				kd = (kd < 0) ? 0 : (kd > 255) ? 255 : kd;
+
+				d |= (colType_t) kd << sh;
+			}
+
+			pixels[x] = d;
+		}
+	}
 }
 
 void drawFillRect(SDL_Surface *surface, int xs, int ys,
@@ -2209,6 +2523,8 @@ void drawDotCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb, double fxs,
 	lcb.max_x = (lcb.max_x > cb->max_x) ? cb->max_x : lcb.max_x;
 	lcb.max_y = (lcb.max_y > cb->max_y) ? cb->max_y : lcb.max_y;
 
+	drawTileMark(dw, dw->tile.canvas, &lcb);
+
 	if (round == 0) {
 
 		w1 = lcb.min_x * 16 - xs + 8;
@@ -2690,6 +3006,8 @@ int drawDotTrial(draw_t *dw, clipBox_t *cb, double fxs, double fys,
 	lcb.max_x = (lcb.max_x > cb->max_x) ? cb->max_x : lcb.max_x;
 	lcb.max_y = (lcb.max_y > cb->max_y) ? cb->max_y : lcb.max_y;
 
+	drawTileMark(dw, dw->tile.trial, &lcb);
+
 	fill = 0;
 
 	if (round == 0) {
@@ -2915,6 +3233,234 @@ int drawDotTrial(draw_t *dw, clipBox_t *cb, double fxs, double fys,
 	return fill;
 }
 
+static float
+drawLog2Fast(float x)
+{
+	union {
+
+		float		f;
+		Uint32		l;
+	}
+	u;
+
+	u.f = x;
+
+	return (float) u.l * (1.f / 8388608.f) - 127.f;
+}
+
+float drawDensityTrial(draw_t *dw, clipBox_t *cb, float *density,
+		double fxs, double fys, int rsize, float weight)
+{
+	int			yspan, xs, ys, xe, ye, x, y;
+	float			*dens, peak;
+
+	rsize = (rsize > 1) ? rsize : 1;
+
+	if (fxs < cb->min_x - rsize || fxs > cb->max_x + rsize)
+		return 0.f;
+
+	if (fys < cb->min_y - rsize || fys > cb->max_y + rsize)
+		return 0.f;
+
+	xs = (int) (fxs - (rsize - 1) * 0.5 + 1.) - 1;
+	ys = (int) (fys - (rsize - 1) * 0.5 + 1.) - 1;
+	xe = xs + rsize - 1;
+	ye = ys + rsize - 1;
+
+	xs = (xs < cb->min_x) ? cb->min_x : xs;
+	ys = (ys < cb->min_y) ? cb->min_y : ys;
+	xe = (xe > cb->max_x) ? cb->max_x : xe;
+	ye = (ye > cb->max_y) ? cb->max_y : ye;
+
+	yspan = dw->pixmap.yspan;
+	dens = density + ys * yspan;
+
+	peak = 0.f;
+
+	for (y = ys; y <= ye; ++y) {
+
+		for (x = xs; x <= xe; ++x) {
+
+			*(dens + x) += weight;
+
+			peak = (*(dens + x) > peak) ? *(dens + x) : peak;
+		}
+
+		dens += yspan;
+	}
+
+	return peak;
+}
+
+float drawDensityLine(draw_t *dw, clipBox_t *cb, float *density, double fxs,
+		double fys, double fxe, double fye, float weight)
+{
+	double			dx, dy, t0, t1, q[4], p[4];
+	int			yspan, x, y, N, n;
+	float			*dens, peak;
+
+	dx = fxe - fxs;
+	dy = fye - fys;
+
+	p[0] = - dx;
+	p[1] = dx;
+	p[2] = - dy;
+	p[3] = dy;
+
+	q[0] = fxs - cb->min_x;
+	q[1] = cb->max_x + 1. - fxs;
+	q[2] = fys - cb->min_y;
+	q[3] = cb->max_y + 1. - fys;
+
+	t0 = 0.;
+	t1 = 1.;
+
+	for (N = 0; N < 4; ++N) {
+
+		if (p[N] == 0.) {
+
+			if (q[N] < 0.)
+				return 0.f;
+		}
+		else if (p[N] < 0.) {
+
+			t0 = (q[N] / p[N] > t0) ? q[N] / p[N] : t0;
+		}
+		else {
+			t1 = (q[N] / p[N] < t1) ? q[N] / p[N] : t1;
+		}
+	}
+
+	if (t0 > t1)
+		return 0.f;
+
+	/* Walk the segment with one hit per pixel step. The start point is
+	 * skipped as it was the end point of the previous segment.
+	 * */
+	n = (int) ceil(((fabs(dx) > fabs(dy)) ? fabs(dx) : fabs(dy)) * (t1 - t0));
+	n = (n < 1) ? 1 : n;
+
+	fxe = fxs + dx * t1;
+	fye = fys + dy * t1;
+	fxs = fxs + dx * t0;
+	fys = fys + dy * t0;
+
+	dx = (fxe - fxs) / (double) n;
+	dy = (fye - fys) / (double) n;
+
+	yspan = dw->pixmap.yspan;
+	peak = 0.f;
+
+	for (N = 1; N <= n; ++N) {
+
+		x = (int) (fxs + dx * N);
+		y = (int) (fys + dy * N);
+
+		x = (x < cb->min_x) ? cb->min_x : (x > cb->max_x) ? cb->max_x : x;
+		y = (y < cb->min_y) ? cb->min_y : (y > cb->max_y) ? cb->max_y : y;
+
+		dens = density + y * yspan + x;
+		*dens += weight;
+
+		peak = (*dens > peak) ? *dens : peak;
+	}
+
+	return peak;
+}
+
+void drawDensityCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb,
+		const float *density, float peak, int ncol, const double map[4])
+{
+	svg_t			*g = (svg_t *) surface->userdata;
+	colType_t		*pixels = (colType_t *) surface->pixels;
+
+	int			*xmap, pitch, yspan, x, y, xs, ys, run;
+	float			nb, lpeak;
+	double			fys;
+
+	colType_t		col, bg, rb, gg;
+	const float		*dens;
+
+	if (peak <= 0.f)
+		return ;
+
+	xmap = (int *) malloc(sizeof(int) * (cb->max_x + 1));
+
+	if (xmap == NULL) {
+
+		ERROR("Unable to allocate memory of density map\n");
+		return ;
+	}
+
+	for (x = cb->min_x; x <= cb->max_x; ++x) {
+
+		xs = (int) floor(x * map[0] + map[1]);
+		xmap[x] = (xs >= 0 && xs < dw->pixmap.w) ? xs : -1;
+	}
+
+	/* Hit counts are mapped onto alpha with a logarithmic ramp so that
+	 * sparse outliers stay visible next to the dense core.
+	 * */
+	lpeak = 208.f / drawLog2Fast(1.f + peak);
+
+	col = dw->palette[ncol];
+	yspan = dw->pixmap.yspan;
+
+	pitch = surface->pitch / 4;
+	pixels += cb->min_y * pitch;
+
+	for (y = cb->min_y; y <= cb->max_y; ++y) {
+
+		fys = floor(y * map[2] + map[3]);
+		ys = (fys >= 0. && fys < dw->pixmap.h) ? (int) fys : -1;
+
+		if (ys >= 0) {
+
+			dens = density + ys * yspan;
+			run = -1;
+
+			for (x = cb->min_x; x <= cb->max_x; ++x) {
+
+				nb = (xmap[x] >= 0) ? *(dens + xmap[x]) : 0.f;
+
+				if (nb > 0.f) {
+
+					xs = 47 + (int) (drawLog2Fast(1.f + nb) * lpeak);
+					xs = (xs > 255) ? 255 : xs;
+
+					bg = (g != NULL) ? dw->palette[0] : *(pixels + x);
+
+					rb = ((col & 0xFF00FFU) * xs + (bg & 0xFF00FFU) * (256 - xs)) >> 8;
+					gg = ((col & 0x00FF00U) * xs + (bg & 0x00FF00U) * (256 - xs)) >> 8;
+
+					*(pixels + x) = (rb & 0xFF00FFU) | (gg & 0x00FF00U);
+				}
+
+				if (g != NULL) {
+
+					if (run >= 0 && (nb <= 0.f || *(pixels + x) != *(pixels + run))) {
+
+						svgDrawRect(g, run, y, x, y + 1, (svgCol_t) *(pixels + run));
+
+						run = -1;
+					}
+
+					run = (nb > 0.f && run < 0) ? x : run;
+				}
+			}
+
+			if (g != NULL && run >= 0) {
+
+				svgDrawRect(g, run, y, cb->max_x + 1, y + 1, (svgCol_t) *(pixels + run));
+			}
+		}
+
+		pixels += pitch;
+	}
+
+	free(xmap);
+}
+
 void drawMarkCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb, double fxs, double fys,
 		int rsize, int shape, int ncol, int thickness)
 {
@@ -2995,17 +3541,64 @@ void drawMarkCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb, double fxs,
 	}
 }
 
-void drawFlushCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb)
+#define DRAW_SPREAD(c)		(((Uint64) ((c) & 0xFFU))		\
+				| (((Uint64) ((c) & 0xFF00U)) << 8)	\
+				| (((Uint64) ((c) & 0xFF0000U)) << 16))
+
+#define DRAW_PACK(l)		((colType_t) (((l) & 0xFFU)		\
+				| (((l) >> 8) & 0xFF00U)		\
+				| (((l) >> 16) & 0xFF0000U)))
+
+typedef struct {
+
+	draw_t			*dw;
+	SDL_Surface		*surface;
+	clipBox_t		cb;
+
+	/* Packed sum of two palette colours indexed by a canvas byte, and
+	 * the number of background samples in that byte.
+	 * */
+	Uint64			pair[256];
+	Uint8			zero[256];
+}
+flush_t;
+
+static int
+drawSpanZero(const void *span)
 {
-	colType_t		*pixels = (colType_t *) surface->pixels;
+#ifdef __SSE2__
+	__m128i		v = _mm_loadu_si128((const __m128i *) span);
+
+	return (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF) ? 1 : 0;
+#else /* __SSE2__ */
+	Uint64		l[2];
+
+	memcpy(l, span, sizeof(l));
+
+	return ((l[0] | l[1]) == 0U) ? 1 : 0;
+#endif
+}
+
+static void
+drawFlushBand(flush_t *fl)
+{
+	draw_t			*dw = fl->dw;
+	colType_t		*pixels = (colType_t *) fl->surface->pixels;
 	colType_t		*palette = dw->palette;
+	clipBox_t		*cb = &fl->cb;
+	Uint8			*tile;
 
-	int			pitch, x, y;
-	int			yspan, ncol, blend[3];
+	int			pitch, x, y, xs, xe, tx, txs, txe, yspan;
+	Uint64			blend;
 
-	pitch = surface->pitch / 4;
+	pitch = fl->surface->pitch / 4;
 	pixels += cb->min_y * pitch;
 
+	/* Only dirty tiles can have something to resolve.
+	 * */
+	txs = cb->min_x >> DRAW_TILE_SHIFT;
+	txe = cb->max_x >> DRAW_TILE_SHIFT;
+
 	if (dw->antialiasing == DRAW_SOLID) {
 
 		Uint8		nb, *canvas = (Uint8 *) dw->pixmap.canvas;
@@ -3015,13 +3608,34 @@ void drawFlushCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb)
 
 		for (y = cb->min_y; y <= cb->max_y; ++y) {
 
-			for (x = cb->min_x; x <= cb->max_x; ++x) {
+			tile = dw->tile.canvas + (y >> DRAW_TILE_SHIFT) * dw->tile.w;
+
+			for (tx = txs; tx <= txe; ++tx) {
+
+				if (tile[tx] == 0)
+					continue;
+
+				xs = tx << DRAW_TILE_SHIFT;
+				xe = xs + (1 << DRAW_TILE_SHIFT) - 1;
 
-				nb = *(canvas + x);
+				xs = (xs < cb->min_x) ? cb->min_x : xs;
+				xe = (xe > cb->max_x) ? cb->max_x : xe;
 
-				if (nb != 0) {
+				for (x = xs; x <= xe; ++x) {
 
-					*(pixels + x) = palette[nb];
+					if ((x & 15) == 0 && x + 15 <= xe
+							&& drawSpanZero(canvas + x) != 0) {
+
+						x += 15;
+						continue;
+					}
+
+					nb = *(canvas + x);
+
+					if (nb != 0) {
+
+						*(pixels + x) = palette[nb];
+					}
 				}
 			}
 
@@ -3033,60 +3647,46 @@ void drawFlushCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb)
 
 		Uint16		nb, *canvas = (Uint16 *) dw->pixmap.canvas;
 
-		union {
-
-			Uint32          l;
-			Uint8           b[4];
-		}
-		vcol;
-
 		yspan = dw->pixmap.yspan;
 		canvas += cb->min_y * yspan;
 
 		for (y = cb->min_y; y <= cb->max_y; ++y) {
 
-			for (x = cb->min_x; x <= cb->max_x; ++x) {
+			tile = dw->tile.canvas + (y >> DRAW_TILE_SHIFT) * dw->tile.w;
 
-				nb = *(canvas + x);
+			for (tx = txs; tx <= txe; ++tx) {
 
-				if (nb != 0) {
+				if (tile[tx] == 0)
+					continue;
 
-					palette[0] = *(pixels + x);
+				xs = tx << DRAW_TILE_SHIFT;
+				xe = xs + (1 << DRAW_TILE_SHIFT) - 1;
 
-					ncol = (nb & 0x000FU) >> 0;
-					vcol.l = palette[ncol];
+				xs = (xs < cb->min_x) ? cb->min_x : xs;
+				xe = (xe > cb->max_x) ? cb->max_x : xe;
 
-					blend[0] = vcol.b[0];
-					blend[1] = vcol.b[1];
-					blend[2] = vcol.b[2];
+				for (x = xs; x <= xe; ++x) {
 
-					ncol = (nb & 0x00F0U) >> 4;
-					vcol.l = palette[ncol];
+					if ((x & 15) == 0 && x + 15 <= xe
+							&& drawSpanZero(canvas + x) != 0
+							&& drawSpanZero(canvas + x + 8) != 0) {
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
-
-					ncol = (nb & 0x0F00U) >> 8;
-					vcol.l = palette[ncol];
+						x += 15;
+						continue;
+					}
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+					nb = *(canvas + x);
 
-					ncol = (nb & 0xF000U) >> 12;
-					vcol.l = palette[ncol];
+					if (nb != 0) {
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+						blend = fl->pair[nb & 0xFFU] + fl->pair[nb >> 8];
+						blend += (fl->zero[nb & 0xFFU] + fl->zero[nb >> 8])
+							* DRAW_SPREAD(*(pixels + x));
 
-					vcol.b[0] = blend[0] >> 2;
-					vcol.b[1] = blend[1] >> 2;
-					vcol.b[2] = blend[2] >> 2;
-					vcol.b[3] = 0;
+						blend = (blend >> 2) & 0x00FF00FF00FFU;
 
-					*(pixels + x) = vcol.l;
+						*(pixels + x) = DRAW_PACK(blend);
+					}
 				}
 			}
 
@@ -3098,96 +3698,218 @@ void drawFlushCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb)
 
 		Uint16		nb[2], *canvas = (Uint16 *) dw->pixmap.canvas;
 
-		union {
-
-			Uint32          l;
-			Uint8           b[4];
-		}
-		vcol;
-
 		yspan = dw->pixmap.yspan * 2;
 		canvas += cb->min_y * yspan;
 
 		for (y = cb->min_y; y <= cb->max_y; ++y) {
 
-			for (x = cb->min_x; x <= cb->max_x; ++x) {
+			tile = dw->tile.canvas + (y >> DRAW_TILE_SHIFT) * dw->tile.w;
+
+			for (tx = txs; tx <= txe; ++tx) {
+
+				if (tile[tx] == 0)
+					continue;
 
-				nb[0] = *(canvas + x * 2 + 0);
-				nb[1] = *(canvas + x * 2 + 1);
+				xs = tx << DRAW_TILE_SHIFT;
+				xe = xs + (1 << DRAW_TILE_SHIFT) - 1;
 
-				if (		   nb[0] != 0
-						|| nb[1] != 0) {
+				xs = (xs < cb->min_x) ? cb->min_x : xs;
+				xe = (xe > cb->max_x) ? cb->max_x : xe;
 
-					palette[0] = *(pixels + x);
+				for (x = xs; x <= xe; ++x) {
 
-					ncol = (nb[0] & 0x000FU) >> 0;
-					vcol.l = palette[ncol];
+					if ((x & 15) == 0 && x + 15 <= xe
+							&& drawSpanZero(canvas + x * 2) != 0
+							&& drawSpanZero(canvas + x * 2 + 8) != 0
+							&& drawSpanZero(canvas + x * 2 + 16) != 0
+							&& drawSpanZero(canvas + x * 2 + 24) != 0) {
 
-					blend[0] = vcol.b[0];
-					blend[1] = vcol.b[1];
-					blend[2] = vcol.b[2];
+						x += 15;
+						continue;
+					}
 
-					ncol = (nb[0] & 0x00F0U) >> 4;
-					vcol.l = palette[ncol];
+					nb[0] = *(canvas + x * 2 + 0);
+					nb[1] = *(canvas + x * 2 + 1);
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+					if (		   nb[0] != 0
+							|| nb[1] != 0) {
 
-					ncol = (nb[0] & 0x0F00U) >> 8;
-					vcol.l = palette[ncol];
+						blend = fl->pair[nb[0] & 0xFFU] + fl->pair[nb[0] >> 8]
+							+ fl->pair[nb[1] & 0xFFU] + fl->pair[nb[1] >> 8];
+						blend += (fl->zero[nb[0] & 0xFFU] + fl->zero[nb[0] >> 8]
+							+ fl->zero[nb[1] & 0xFFU] + fl->zero[nb[1] >> 8])
+							* DRAW_SPREAD(*(pixels + x));
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+						blend = (blend >> 3) & 0x00FF00FF00FFU;
 
-					ncol = (nb[0] & 0xF000U) >> 12;
-					vcol.l = palette[ncol];
+						*(pixels + x) = DRAW_PACK(blend);
+					}
+				}
+			}
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+			pixels += pitch;
+			canvas += yspan;
+		}
+	}
+}
+
+static int
+drawFlushThread(void *data)
+{
+	draw_t			*dw = (draw_t *) data;
+	flush_t			*fl = (flush_t *) dw->flush.task;
+	int			N;
 
-					ncol = (nb[1] & 0x000FU) >> 0;
-					vcol.l = palette[ncol];
+	do {
+		SDL_SemWait(dw->flush.sem_run);
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+		if (dw->flush.stop != 0)
+			break;
 
-					ncol = (nb[1] & 0x00F0U) >> 4;
-					vcol.l = palette[ncol];
+		/* Any of the woken workers takes the next band.
+		 * */
+		N = SDL_AtomicAdd(&dw->flush.next, 1);
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+		drawFlushBand(&fl[N]);
 
-					ncol = (nb[1] & 0x0F00U) >> 8;
-					vcol.l = palette[ncol];
+		SDL_SemPost(dw->flush.sem_done);
+	}
+	while (1);
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+	return 0;
+}
 
-					ncol = (nb[1] & 0xF000U) >> 12;
-					vcol.l = palette[ncol];
+static int
+drawFlushStart(draw_t *dw, int tN)
+{
+	if (dw->flush.task == NULL) {
 
-					blend[0] += vcol.b[0];
-					blend[1] += vcol.b[1];
-					blend[2] += vcol.b[2];
+		dw->flush.task = malloc(sizeof(flush_t) * DRAW_THREADS_MAX);
+		dw->flush.sem_run = SDL_CreateSemaphore(0);
+		dw->flush.sem_done = SDL_CreateSemaphore(0);
 
-					vcol.b[0] = blend[0] >> 3;
-					vcol.b[1] = blend[1] >> 3;
-					vcol.b[2] = blend[2] >> 3;
-					vcol.b[3] = 0;
+		if (		dw->flush.task == NULL
+				|| dw->flush.sem_run == NULL
+				|| dw->flush.sem_done == NULL) {
 
-					*(pixels + x) = vcol.l;
-				}
-			}
+			ERROR("Unable to allocate flush workers\n");
+			drawFlushClean(dw);
 
-			pixels += pitch;
-			canvas += yspan;
+			return 0;
 		}
 	}
+
+	while (dw->flush.N < tN - 1) {
+
+		dw->flush.thread[dw->flush.N] = SDL_CreateThread(&drawFlushThread,
+				"flush", dw);
+
+		if (dw->flush.thread[dw->flush.N] == NULL)
+			break;
+
+		dw->flush.N += 1;
+	}
+
+	return dw->flush.N + 1;
+}
+
+void drawFlushClean(draw_t *dw)
+{
+	int			N;
+
+	dw->flush.stop = 1;
+
+	for (N = 0; N < dw->flush.N; ++N)
+		SDL_SemPost(dw->flush.sem_run);
+
+	for (N = 0; N < dw->flush.N; ++N)
+		SDL_WaitThread(dw->flush.thread[N], NULL);
+
+	if (dw->flush.sem_run != NULL) {
+
+		SDL_DestroySemaphore(dw->flush.sem_run);
+	}
+
+	if (dw->flush.sem_done != NULL) {
+
+		SDL_DestroySemaphore(dw->flush.sem_done);
+	}
+
+	free(dw->flush.task);
+
+	memset(&dw->flush, 0, sizeof(dw->flush));
 }
 
+void drawFlushCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb)
+{
+	flush_t			fl0, *fl = &fl0;
+
+	Uint64			spread[16];
+	int			N, tN, ymin, ylen;
+
+	/* Split the large viewport into horizontal bands and resolve them
+	 * in parallel. Small ones are not worth of waking the workers.
+	 * */
+	ylen = cb->max_y - cb->min_y + 1;
+	tN = (cb->max_x - cb->min_x + 1) * ylen / DRAW_THREADS_AREA;
+
+	tN = (tN > SDL_GetCPUCount()) ? SDL_GetCPUCount() : tN;
+	tN = (tN > DRAW_THREADS_MAX) ? DRAW_THREADS_MAX : tN;
+	tN = (tN > ylen) ? ylen : tN;
+
+	if (tN > 1) {
+
+		tN = drawFlushStart(dw, tN);
+		fl = (tN > 1) ? (flush_t *) dw->flush.task : fl;
+	}
+
+	fl[0].dw = dw;
+	fl[0].surface = surface;
+	fl[0].cb = *cb;
+
+	if (dw->antialiasing != DRAW_SOLID) {
+
+		spread[0] = 0U;
+
+		for (N = 1; N < 16; ++N)
+			spread[N] = DRAW_SPREAD(dw->palette[N]);
+
+		for (N = 0; N < 256; ++N) {
+
+			fl[0].pair[N] = spread[N & 0xFU] + spread[N >> 4];
+			fl[0].zero[N] = (((N & 0xFU) == 0) ? 1 : 0)
+				+ (((N >> 4) == 0) ? 1 : 0);
+		}
+	}
+
+	if (tN > 1) {
+
+		ymin = cb->min_y;
+
+		for (N = 0; N < tN; ++N) {
+
+			if (N != 0) {
+
+				memcpy(&fl[N], &fl[0], sizeof(flush_t));
+			}
+
+			fl[N].cb.min_y = ymin;
+			fl[N].cb.max_y = cb->min_y + ylen * (N + 1) / tN - 1;
+
+			ymin = fl[N].cb.max_y + 1;
+		}
+
+		SDL_AtomicSet(&dw->flush.next, 1);
+
+		for (N = 1; N < tN; ++N)
+			SDL_SemPost(dw->flush.sem_run);
+
+		drawFlushBand(&fl[0]);
+
+		for (N = 1; N < tN; ++N)
+			SDL_SemWait(dw->flush.sem_done);
+	}
+	else {
+		drawFlushBand(&fl[0]);
+	}
+}
@@ -24,6 +24,14 @@
 
 typedef Uint32		colType_t;
 
+#define DRAW_THREADS_MAX	8
+#define DRAW_THREADS_AREA	400000
+
+#define DRAW_TILE_SHIFT		5
+
+#define DRAW_TEXT_CACHE_MAX	128
+#define DRAW_TEXT_CACHE_LEN	96
+
 enum {
 	TEXT_CENTERED_ON_X	= 1,
 	TEXT_CENTERED_ON_Y	= 2,
@@ -57,6 +65,21 @@ typedef struct {
 }
 clipBox_t;
 
+typedef struct {
+
+	TTF_Font	*font;
+	colType_t	col;
+	int		flags;
+
+	Uint32		hash;
+	Uint32		stamp;
+
+	char		text[DRAW_TEXT_CACHE_LEN];
+
+	SDL_Surface	*surface;
+}
+textCache_t;
+
 typedef struct {
 
 	int		antialiasing;
@@ -83,6 +106,44 @@ typedef struct {
 	}
 	pixmap;
 
+	/* Coarse bitmaps of pixmap tiles that were touched by rasterizers
+	 * since the last clear.
+	 * */
+	struct {
+
+		int	w;
+		int	h;
+
+		int	len;
+		int	antialiasing;
+
+		Uint8	*canvas;
+		Uint8	*trial;
+	}
+	tile;
+
+	/* Workers that resolve bands of the canvas, they are started
+	 * once and then woken on each flush.
+	 * */
+	struct {
+
+		int		N;
+
+		SDL_Thread	*thread[DRAW_THREADS_MAX];
+		SDL_sem		*sem_run;
+		SDL_sem		*sem_done;
+		SDL_atomic_t	next;
+
+		int		stop;
+		void		*task;
+	}
+	flush;
+
+	/* Rendered text surfaces that are reused in LRU order.
+	 * */
+	textCache_t	text_cache[DRAW_TEXT_CACHE_MAX];
+	Uint32		text_stamp;
+
 	colType_t	palette[16];
 }
 draw_t;
@@ -113,9 +174,13 @@ void drawDashCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb, double fxs,
 int drawLineTrial(draw_t *dw, clipBox_t *cb, double fxs, double fys,
 		double fxe, double fye, int ncol, int thickness);
 
+void drawTextCacheClean(draw_t *dw);
+
 void drawText(draw_t *dw, SDL_Surface *surface, TTF_Font *font, int xs, int ys,
 		const char *text, int flags, colType_t col);
 
+void drawOverlay(SDL_Surface *surface, SDL_Surface *black, SDL_Surface *white,
+		clipBox_t *cb);
 void drawFillRect(SDL_Surface *surface, int xs, int ys,
 		int xe, int ye, colType_t col);
 
@@ -128,10 +193,20 @@ void drawDotCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb, double fxs,
 int drawDotTrial(draw_t *dw, clipBox_t *cb, double fxs, double fys,
 		int rsize, int ncol, int round);
 
+float drawDensityTrial(draw_t *dw, clipBox_t *cb, float *density,
+		double fxs, double fys, int rsize, float weight);
+
+float drawDensityLine(draw_t *dw, clipBox_t *cb, float *density, double fxs,
+		double fys, double fxe, double fye, float weight);
+
+void drawDensityCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb,
+		const float *density, float peak, int ncol, const double map[4]);
+
 void drawMarkCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb, double fxs, double fys,
 		int rsize, int shape, int ncol, int thickness);
 
 void drawFlushCanvas(draw_t *dw, SDL_Surface *surface, clipBox_t *cb);
+void drawFlushClean(draw_t *dw);
 
 #endif /* _H_DRAW_ */
 
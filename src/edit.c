@@ -405,9 +405,17 @@ void editDraw(edit_t *ed, SDL_Surface *surface)
 	char		curbuf[EDIT_STRING_MAX];
 	int		baseX, baseY, endX, endY;
 
+	ed->damage.min_x = 0;
+	ed->damage.max_x = -1;
+
 	if (ed->raised == 0)
 		return ;
 
+	ed->damage.min_x = ed->box_X;
+	ed->damage.min_y = ed->box_Y;
+	ed->damage.max_x = ed->box_X + ed->size_X;
+	ed->damage.max_y = ed->box_Y + ed->size_Y;
+
 	SDL_LockSurface(surface);
 
 	drawFillRect(surface, ed->box_X, ed->box_Y, ed->box_X + ed->size_X,
@@ -48,6 +48,10 @@ typedef struct {
 	TTF_Font		*font;
 	clipBox_t		screen;
 
+	/* Region that was drawn over by the last editDraw.
+	 * */
+	clipBox_t		damage;
+
 	char			text[EDIT_STRING_MAX];
 	char			*text_cur;
 
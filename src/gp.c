@@ -44,6 +44,16 @@
 #undef main
 
 #define GP_FILE_DIR_MAX			4000
+#define GP_EXPORT_THREADS_MAX		64
+
+#define GP_FRAME_PERIOD_DEFAULT		16
+#define GP_INTERACTIVE_HOLD		250
+#define GP_IDLE_FRAMES			4
+#define GP_BUDGET_MIN			2
+#define GP_WAIT_MAX			1000
+#define GP_WAIT_POLL			5
+
+#define GP_RECTS_MAX			64
 
 typedef struct {
 
@@ -62,6 +72,15 @@ typedef struct {
 	SDL_Surface	*fb;
 	SDL_Surface	*surface;
 
+	/* Regions that were drawn over by the previous frame go first and
+	 * are shown again to wipe out what has gone.
+	 * */
+	SDL_Rect	damage[GP_RECTS_MAX];
+	int		damage_N;
+	int		damage_last_N;
+
+	int		present_full;
+
 	char		sbuf[4][READ_FILE_PATH_MAX];
 
 	char		rcfile[READ_FILE_PATH_MAX];
@@ -72,11 +91,19 @@ typedef struct {
 
 	int		active;
 	int		unfinished;
+	int		reading;
+
+	Uint32		event_async;
 
 	int		clock;
 	int		idled;
 	int		updated;
 
+	int		frame_period;
+	int		input_clock;
+	int		t_read;
+	int		t_overhead;
+
 	int		ctrl_on;
 	int		shift_on;
 
@@ -102,6 +129,7 @@ typedef struct {
 
 	int		screen_take;
 	int		screen_yank;
+	SDL_atomic_t	screen_busy;
 	int		legend_drag;
 	int		data_box_drag;
 	int		combine_on;
@@ -113,6 +141,12 @@ typedef struct {
 	int		layout_menu_dir_margin;
 	int		layout_menu_dataset_margin;
 
+	char		export_file[READ_FILE_PATH_MAX];
+	char		export_pages[PLOT_STRING_MAX];
+	int		export_size_x;
+	int		export_size_y;
+	int		export_threads;
+
 	char		current_dir[READ_FILE_PATH_MAX];
 	char		dirent_names[GP_FILE_DIR_MAX][PLOT_STRING_MAX];
 	int		current_dir_ok;
@@ -121,6 +155,35 @@ typedef struct {
 }
 gp_t;
 
+typedef struct {
+
+	gp_t		*gp;
+	plot_t		*pl;
+	draw_t		*dw;
+
+	SDL_Surface	*surface;
+	SDL_Thread	*thread;
+
+	const int	*list;
+	int		list_N;
+	SDL_atomic_t	*next;
+
+	char		sbuf[2][READ_FILE_PATH_MAX];
+	char		file[READ_FILE_PATH_MAX];
+
+	int		failed;
+}
+export_t;
+
+typedef struct {
+
+	SDL_Surface	*surface;
+	SDL_atomic_t	*busy;
+
+	char		file[READ_FILE_PATH_MAX];
+}
+screen_t;
+
 enum {
 	GP_IDLE			= 0,
 	GP_MOVING,
@@ -293,6 +356,15 @@ gpScreenLength(plot_t *pl)
 	return pl->screen.max_x / pl->layout_font_long;
 }
 
+static void
+gpPlotTitle(plot_t *pl, const char *title)
+{
+	/* Title is drawn by plot along with the legend.
+	 * */
+	strncpy(pl->title, title, sizeof(pl->title) - 1);
+	pl->title[sizeof(pl->title) - 1] = 0;
+}
+
 static void
 gpTextLeftCrop(plot_t *pl, char *sbuf, const char *text, int margin)
 {
@@ -372,6 +444,10 @@ gpFontHinting(gp_t *gp)
 {
 	plot_t		*pl = gp->pl;
 
+	drawTextCacheClean(pl->dw);
+
+	pl->layer_valid = 0;
+
 	if (gp->hinting == 0) {
 
 		TTF_SetFontHinting(pl->font, TTF_HINTING_NONE);
@@ -691,15 +767,15 @@ gpInsertColumn(gp_t *gp, char **la, int dN, int cN)
 
 	sprintf(gp->sbuf[0], "[%3i] %.75s", cN, rd->data[dN].label[cN]);
 
-	if (rd->data[dN].hint[cN] == DATA_HINT_FLOAT) {
+	if (SDL_AtomicGet(&rd->data[dN].hint[cN]) == DATA_HINT_FLOAT) {
 
 		strcat(gp->sbuf[0], " (DEC)");
 	}
-	else if (rd->data[dN].hint[cN] == DATA_HINT_HEX) {
+	else if (SDL_AtomicGet(&rd->data[dN].hint[cN]) == DATA_HINT_HEX) {
 
 		strcat(gp->sbuf[0], " (HEX)");
 	}
-	else if (rd->data[dN].hint[cN] == DATA_HINT_OCT) {
+	else if (SDL_AtomicGet(&rd->data[dN].hint[cN]) == DATA_HINT_OCT) {
 
 		strcat(gp->sbuf[0], " (OCT)");
 	}
@@ -739,6 +815,18 @@ gpInsertDataset(gp_t *gp, char **la, int dN)
 
 		sformat = "DOUBLE";
 	}
+	else if (rd->data[dN].format == FORMAT_BINARY_STRUCT) {
+
+		sformat = "STRUCT";
+	}
+	else if (rd->data[dN].format == FORMAT_BINARY_NPY) {
+
+		sformat = "NUMPY ";
+	}
+	else if (rd->data[dN].format == FORMAT_BINARY_SHM) {
+
+		sformat = "SHMEM ";
+	}
 	else {
 		sformat = "LEGACY";
 	}
@@ -1075,14 +1163,64 @@ gpWriteConfiguration(gp_t *gp)
 	}
 }
 
+static int
+gpScreenSave(screen_t *sc)
+{
+	if (IMG_SavePNG(sc->surface, sc->file) == 0) {
+
+		ERROR("Screen was saved to \"%s\"\n", sc->file);
+	}
+	else {
+		ERROR("IMG_SavePNG: \"%s\"\n", IMG_GetError());
+	}
+
+	SDL_FreeSurface(sc->surface);
+	SDL_AtomicAdd(sc->busy, -1);
+
+	free(sc);
+
+	return 0;
+}
+
 static void
 gpTakeScreen(gp_t *gp)
 {
+	screen_t	*sc;
+	SDL_Thread	*thread;
+
 	if (gp->screen_take == 1) {
 
-		if (IMG_SavePNG(gp->surface, gp->tempfile) == 0) {
+		/* We encode a copy of the surface in background so the next
+		 * frames can be drawn meanwhile.
+		 * */
+		sc = (screen_t *) malloc(sizeof(screen_t));
+
+		if (sc != NULL) {
+
+			sc->surface = SDL_DuplicateSurface(gp->surface);
+			sc->busy = &gp->screen_busy;
+
+			strcpy(sc->file, gp->tempfile);
+		}
+
+		if (sc == NULL || sc->surface == NULL) {
+
+			ERROR("Unable to copy the screen surface\n");
+			free(sc);
+		}
+		else {
+			SDL_AtomicAdd(&gp->screen_busy, 1);
+
+			thread = SDL_CreateThread((int (*) (void *)) &gpScreenSave,
+					"gpScreenSave", sc);
 
-			ERROR("Screen was saved to \"%s\"\n", gp->tempfile);
+			if (thread != NULL) {
+
+				SDL_DetachThread(thread);
+			}
+			else {
+				gpScreenSave(sc);
+			}
 		}
 	}
 	else if (gp->screen_take == 2) {
@@ -1155,6 +1293,382 @@ gpYankScreen(gp_t *gp)
 	gp->screen_yank = 0;
 }
 
+static int
+gpExportName(const char *pattern, int pN, char *file)
+{
+	const char	*s;
+	int		n = 0;
+
+	/* The pattern may contain one integer conversion like "%03d" to be
+	 * replaced by the page number.
+	 * */
+	for (s = pattern; *s != 0; ++s) {
+
+		if (*s == '%') {
+
+			s += strspn(s + 1, "0123456789") + 1;
+
+			if (*s != 'd' && *s != 'i') {
+
+				ERROR("Invalid conversion in \"%s\"\n", pattern);
+				return -1;
+			}
+
+			n++;
+		}
+	}
+
+	if (n > 1) {
+
+		ERROR("Too many conversions in \"%s\"\n", pattern);
+		return -1;
+	}
+
+	if (snprintf(file, READ_FILE_PATH_MAX, pattern, pN) >= READ_FILE_PATH_MAX) {
+
+		ERROR("Too long file name\n");
+		return -1;
+	}
+
+	return n;
+}
+
+static int
+gpExportPageSelected(gp_t *gp, int pN)
+{
+	const char	*s = gp->export_pages;
+	int		n, pS, pE;
+
+	if (*s == 0)
+		return 1;
+
+	while (*s != 0) {
+
+		n = sscanf(s, "%d-%d", &pS, &pE);
+
+		if (n < 1)
+			break;
+
+		pE = (n == 1) ? pS : pE;
+
+		if (pN >= pS && pN <= pE)
+			return 1;
+
+		s += strcspn(s, ",");
+		s += (*s == ',') ? 1 : 0;
+	}
+
+	return 0;
+}
+
+static int
+gpExportPage(export_t *ex, int pN)
+{
+	gp_t		*gp = ex->gp;
+	plot_t		*pl = ex->pl;
+	read_t		*rd = gp->rd;
+	svg_t		*g = NULL;
+
+	double		scale[PLOT_AXES_MAX], offset[PLOT_AXES_MAX];
+	const char	*ft;
+	int		N, aN;
+
+	ft = ex->file + strlen(ex->file);
+	while (ft != ex->file && *ft != '.') --ft;
+
+	if (		strcmp(ft, ".png") != 0
+			&& strcmp(ft, ".svg") != 0) {
+
+		ERROR("Unknown file type \"%s\"\n", ex->file);
+		return -1;
+	}
+
+	readSelectPagePlot(rd, pl, pN);
+
+	gpTextLeftCrop(pl, ex->sbuf[1], rd->page[pN].title,
+			gp->layout_menu_page_margin);
+
+	sprintf(ex->sbuf[0], "%3d. %s", pN, ex->sbuf[1]);
+	gpPlotTitle(pl, ex->sbuf[0]);
+
+	for (aN = 0; aN < PLOT_AXES_MAX; ++aN) {
+
+		scale[aN] = 0.;
+		offset[aN] = 0.;
+	}
+
+	for (N = 0; N < 4; ++N) {
+
+		plotLayout(pl);
+		plotAxisScaleDefault(pl);
+
+		if (N != 0) {
+
+			/* Persistence figures define their extent only during
+			 * drawing so we repeat until the scale has settled.
+			 * */
+			for (aN = 0; aN < PLOT_AXES_MAX; ++aN) {
+
+				if (		pl->axis[aN].scale != scale[aN]
+						|| pl->axis[aN].offset != offset[aN])
+					break;
+			}
+
+			if (aN >= PLOT_AXES_MAX)
+				break;
+		}
+
+		for (aN = 0; aN < PLOT_AXES_MAX; ++aN) {
+
+			scale[aN] = pl->axis[aN].scale;
+			offset[aN] = pl->axis[aN].offset;
+		}
+
+		plotDrawLayer(pl, ex->surface);
+		plotDraw(pl, ex->surface);
+	}
+
+	if (strcmp(ft, ".svg") == 0) {
+
+		g = svgOpenNew(ex->file, ex->surface->w, ex->surface->h);
+
+		if (g == NULL) {
+
+			ERROR("Unable to open \"%s\"\n", ex->file);
+			return -1;
+		}
+
+		g->font_family = "monospace";
+		g->font_pt = pl->layout_font_pt;
+
+		ex->surface->userdata = (void *) g;
+
+		plotDrawLayer(pl, ex->surface);
+		plotDraw(pl, ex->surface);
+	}
+
+	if (g != NULL) {
+
+		svgClose(g);
+		ex->surface->userdata = NULL;
+	}
+	else if (IMG_SavePNG(ex->surface, ex->file) != 0) {
+
+		ERROR("IMG_SavePNG: \"%s\"\n", IMG_GetError());
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+gpExportRun(export_t *ex)
+{
+	int		N, pN;
+
+	while ((N = SDL_AtomicAdd(ex->next, 1)) < ex->list_N) {
+
+		pN = ex->list[N];
+
+		if (gpExportName(ex->gp->export_file, pN, ex->file) < 0) {
+
+			ex->failed = 1;
+		}
+		else if (gpExportPage(ex, pN) != 0) {
+
+			ex->failed = 1;
+		}
+		else {
+			ERROR("Page %i was saved to \"%s\"\n", pN, ex->file);
+		}
+	}
+
+	return 0;
+}
+
+static int
+gpExportShared(gp_t *gp, const int *list, int list_N)
+{
+	plot_t		*pl = gp->pl;
+	int		N, dN, sN;
+
+	plotDataRangeCacheSubtractClean(pl);
+	plotDataSubtractClean(pl);
+
+	for (N = 0; N < list_N; ++N)
+		readSubtractPage(gp->rd, list[N]);
+
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (pl->data[dN].column_N != 0) {
+
+			for (sN = 0; sN < PLOT_SUBTRACT; ++sN) {
+
+				if (pl->data[dN].sub[sN].busy == SUBTRACT_FREE)
+					break;
+			}
+
+			if (sN >= PLOT_SUBTRACT) {
+
+				/* Subtract columns of all pages may not fit
+				 * together.
+				 * */
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+static int
+gpExportBatch(gp_t *gp)
+{
+	plot_t		*pl = gp->pl;
+	read_t		*rd = gp->rd;
+
+	export_t	*ex;
+	SDL_atomic_t	next;
+
+	int		list[READ_PAGE_MAX];
+	int		pN, N, list_N, ex_N, failed = 0;
+
+	for (pN = 1, list_N = 0; pN < READ_PAGE_MAX; ++pN) {
+
+		if (		rd->page[pN].busy != 0
+				&& gpExportPageSelected(gp, pN) != 0)
+			list[list_N++] = pN;
+	}
+
+	if (list_N == 0) {
+
+		ERROR("No pages to export\n");
+		return 1;
+	}
+
+	if (gpExportName(gp->export_file, 0, gp->tempfile) == 0 && list_N > 1) {
+
+		ERROR("Use %%d in file name to export %i pages\n", list_N);
+		return 1;
+	}
+
+	/* Load all of the data before drawing since there is nobody to
+	 * watch the progress.
+	 * */
+	readProjection(rd);
+	readUpdateAll(rd);
+
+	pl->screen.min_x = 0;
+	pl->screen.max_x = gp->surface->w - 1;
+	pl->screen.min_y = gp->layout_page_box;
+	pl->screen.max_y = gp->surface->h - 1;
+
+	pl->draw_budget = 0;
+
+	ex_N = (gp->export_threads != 0) ? gp->export_threads : SDL_GetCPUCount();
+	ex_N = (ex_N > list_N) ? list_N : ex_N;
+	ex_N = (ex_N > GP_EXPORT_THREADS_MAX) ? GP_EXPORT_THREADS_MAX : ex_N;
+
+	if (ex_N > 1 && gpExportShared(gp, list, list_N) == 0) {
+
+		ex_N = 1;
+	}
+
+	ex = (export_t *) calloc(ex_N, sizeof(export_t));
+
+	if (ex == NULL) {
+
+		ERROR("No memory allocated for export\n");
+		return 1;
+	}
+
+	SDL_AtomicSet(&next, 0);
+
+	for (N = 0; N < ex_N; ++N) {
+
+		ex[N].gp = gp;
+		ex[N].list = list;
+		ex[N].list_N = list_N;
+		ex[N].next = &next;
+	}
+
+	if (ex_N > 1) {
+
+		/* Each worker draws with its own plot, font and surface
+		 * while dataset rows are shared. Fonts are opened here since
+		 * TTF is not thread safe.
+		 * */
+		for (N = 0; N < ex_N; ++N) {
+
+			ex[N].dw = (draw_t *) calloc(1, sizeof(draw_t));
+
+			if (ex[N].dw == NULL)
+				break;
+
+			ex[N].dw->antialiasing = gp->dw->antialiasing;
+			ex[N].dw->solidfont = gp->dw->solidfont;
+			ex[N].dw->thickness = gp->dw->thickness;
+
+			ex[N].pl = plotClone(pl, ex[N].dw);
+
+			if (ex[N].pl == NULL) {
+
+				free(ex[N].dw);
+				break;
+			}
+
+			ex[N].surface = SDL_CreateRGBSurfaceWithFormat(0, gp->surface->w,
+					gp->surface->h, 32, gp->surface->format->format);
+
+			if (ex[N].surface == NULL) {
+
+				plotCloneClean(ex[N].pl);
+				free(ex[N].dw);
+				break;
+			}
+		}
+
+		ex_N = N;
+
+		for (N = 0; N < ex_N; ++N) {
+
+			ex[N].thread = SDL_CreateThread((int (*) (void *)) &gpExportRun,
+					"gpExportRun", &ex[N]);
+		}
+
+		for (N = 0; N < ex_N; ++N) {
+
+			if (ex[N].thread != NULL) {
+
+				SDL_WaitThread(ex[N].thread, NULL);
+			}
+
+			failed |= ex[N].failed;
+
+			SDL_FreeSurface(ex[N].surface);
+			plotCloneClean(ex[N].pl);
+			free(ex[N].dw);
+		}
+	}
+
+	if (SDL_AtomicGet(&next) < list_N) {
+
+		/* Draw the rest of pages in the main thread.
+		 * */
+		ex[0].pl = pl;
+		ex[0].dw = gp->dw;
+		ex[0].surface = gp->surface;
+
+		gpExportRun(&ex[0]);
+
+		failed |= ex[0].failed;
+	}
+
+	free(ex);
+
+	return failed;
+}
+
 
 static void
 gpMenuHandle(gp_t *gp, int menu_N, int item_N)
@@ -2336,6 +2850,90 @@ gpEditHandle(gp_t *gp, int edit_N, const char *text)
 	}
 }
 
+static int
+gpElapsedUs(Uint64 tSTART)
+{
+	return (int) ((SDL_GetPerformanceCounter() - tSTART) * 1000000U
+			/ SDL_GetPerformanceFrequency());
+}
+
+static void
+gpFramePeriod(gp_t *gp)
+{
+	SDL_DisplayMode		mode;
+	int			N;
+
+	gp->frame_period = GP_FRAME_PERIOD_DEFAULT;
+
+	N = SDL_GetWindowDisplayIndex(gp->window);
+
+	if (N >= 0 && SDL_GetCurrentDisplayMode(N, &mode) == 0) {
+
+		if (mode.refresh_rate > 0) {
+
+			gp->frame_period = 1000 / mode.refresh_rate;
+			gp->frame_period = (gp->frame_period < 4) ? 4 : gp->frame_period;
+		}
+	}
+}
+
+static int
+gpFrameLength(gp_t *gp)
+{
+	int		frame;
+
+	/* During interaction we keep the frame to the display refresh period
+	 * to get low latency. Being idle we make a few times longer frames
+	 * to spend less time to present the progress. On a slow machine idle
+	 * frame is stretched so that overhead takes no more than a quarter.
+	 * */
+	if (gp->clock - gp->input_clock < GP_INTERACTIVE_HOLD) {
+
+		frame = gp->frame_period;
+	}
+	else {
+		frame = gp->frame_period * GP_IDLE_FRAMES;
+
+		if (frame < gp->t_overhead * GP_IDLE_FRAMES / 1000)
+			frame = gp->t_overhead * GP_IDLE_FRAMES / 1000;
+	}
+
+	return frame;
+}
+
+static void
+gpReadBudget(gp_t *gp)
+{
+	read_t		*rd = gp->rd;
+	plot_t		*pl = gp->pl;
+
+	int		frame, spare;
+
+	frame = gpFrameLength(gp);
+	spare = frame - gp->t_overhead / 1000;
+
+	if (pl->draw_in_progress != 0) {
+
+		/* Leave the most of frame to the drawing.
+		 * */
+		spare = (frame == gp->frame_period) ? spare / 4 : spare / 2;
+	}
+
+	rd->read_budget = (spare < GP_BUDGET_MIN) ? GP_BUDGET_MIN : spare;
+}
+
+static void
+gpDrawBudget(gp_t *gp)
+{
+	plot_t		*pl = gp->pl;
+
+	int		spare;
+
+	spare = gpFrameLength(gp) - (gp->t_overhead + gp->t_read) / 1000;
+
+	pl->draw_budget = (spare < GP_BUDGET_MIN) ? GP_BUDGET_MIN : spare;
+}
+
 static void
 gpEventHandle(gp_t *gp)
 {
@@ -2356,6 +2954,7 @@ gpEventHandle(gp_t *gp)
 		if (ev->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
 
 			gp->fb = SDL_GetWindowSurface(gp->window);
+			gp->present_full = 1;
 
 			if (		gp->fb->w != gp->surface->w
 					|| gp->fb->h != gp->surface->h) {
@@ -2384,6 +2983,15 @@ gpEventHandle(gp_t *gp)
 			menuLayout(mu);
 			editLayout(ed);
 		}
+		else if (ev->window.event == SDL_WINDOWEVENT_MOVED) {
+
+			gpFramePeriod(gp);
+		}
+		else if (	ev->window.event == SDL_WINDOWEVENT_EXPOSED
+				|| ev->window.event == SDL_WINDOWEVENT_RESTORED) {
+
+			gp->present_full = 1;
+		}
 		else if (ev->window.event == SDL_WINDOWEVENT_CLOSE) {
 
 			gp->done = 1;
@@ -3333,6 +3941,131 @@ gpDrawBoxSelect(SDL_Surface *surface, gp_t *gp)
 	SDL_UnlockSurface(surface);
 }
 
+static int
+gpWaitTimeout(gp_t *gp)
+{
+	int		wait;
+
+	if (		gp->unfinished != 0 || gp->active != 0
+			|| gp->reading != 0 || gp->i_show_fps != 0) {
+
+		return 0;
+	}
+
+	if (gp->idled < 20) {
+
+		/* Wake up to the next idle update.
+		 * */
+		wait = gp->updated + 251 - (int) SDL_GetTicks();
+		wait = (wait < 1) ? 1 : wait;
+	}
+	else {
+		/* Data arrival is delivered as an event so there is nothing
+		 * to do until something comes.
+		 * */
+		wait = GP_WAIT_MAX;
+	}
+
+	if (readPolled(gp->rd) != 0) {
+
+		/* Rows of shared memory are not delivered as an event.
+		 * */
+		wait = (wait > GP_WAIT_POLL) ? GP_WAIT_POLL : wait;
+	}
+
+	return wait;
+}
+
+static void
+gpDamage(gp_t *gp, const clipBox_t *cb)
+{
+	SDL_Rect	*rect;
+	int		min_x, min_y, max_x, max_y;
+
+	min_x = (cb->min_x < 0) ? 0 : cb->min_x;
+	min_y = (cb->min_y < 0) ? 0 : cb->min_y;
+	max_x = (cb->max_x > gp->surface->w - 1) ? gp->surface->w - 1 : cb->max_x;
+	max_y = (cb->max_y > gp->surface->h - 1) ? gp->surface->h - 1 : cb->max_y;
+
+	if (min_x > max_x || min_y > max_y)
+		return ;
+
+	if (gp->damage_N < GP_RECTS_MAX) {
+
+		rect = &gp->damage[gp->damage_N++];
+
+		rect->x = min_x;
+		rect->y = min_y;
+		rect->w = max_x - min_x + 1;
+		rect->h = max_y - min_y + 1;
+	}
+	else {
+		gp->present_full = 1;
+	}
+}
+
+static void
+gpPresent(gp_t *gp)
+{
+	SDL_Rect	blit;
+	int		N;
+
+	/* Take the regions that were drawn over by each of the parts.
+	 * */
+	for (N = 0; N < gp->pl->damage_N; ++N) {
+
+		gpDamage(gp, &gp->pl->damage[N]);
+	}
+
+	gpDamage(gp, &gp->mu->damage);
+	gpDamage(gp, &gp->ed->damage);
+
+	if (gp->present_full != 0) {
+
+		SDL_BlitSurface(gp->surface, NULL, gp->fb, NULL);
+		SDL_UpdateWindowSurface(gp->window);
+
+		/* We may have lost some of the regions so the next frame
+		 * is to be shown in full.
+		 * */
+		gp->damage[0].x = 0;
+		gp->damage[0].y = 0;
+		gp->damage[0].w = gp->surface->w;
+		gp->damage[0].h = gp->surface->h;
+
+		gp->damage_N = 1;
+		gp->damage_last_N = 0;
+
+		gp->present_full = 0;
+	}
+	else if (gp->damage_N > 0) {
+
+		for (N = 0; N < gp->damage_N; ++N) {
+
+			blit = gp->damage[N];
+
+			SDL_BlitSurface(gp->surface, &gp->damage[N], gp->fb, &blit);
+		}
+
+		SDL_UpdateWindowSurfaceRects(gp->window, gp->damage, gp->damage_N);
+	}
+
+	/* Keep the regions of this frame to be shown next time.
+	 * */
+	if (gp->damage_N > gp->damage_last_N) {
+
+		memmove(gp->damage, gp->damage + gp->damage_last_N,
+				(gp->damage_N - gp->damage_last_N) * sizeof(SDL_Rect));
+
+		gp->damage_N -= gp->damage_last_N;
+	}
+	else {
+		gp->damage_N = 0;
+	}
+
+	gp->damage_last_N = gp->damage_N;
+}
+
 static void
 gpFPSUpdate(gp_t *gp)
 {
@@ -3429,7 +4162,9 @@ int main(int argn, char *argv[])
 	menu_t		*mu;
 	edit_t		*ed;
 
-	int		N, W;
+	clipBox_t	cb;
+	Uint64		tFRAME, tREAD;
+	int		N, W, tUS, rc = 0;
 
 	setlocale(LC_NUMERIC, "C");
 
@@ -3456,7 +4191,64 @@ int main(int argn, char *argv[])
 	ed = editAlloc(dw, sch);
 	gp->ed = ed;
 
-	SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+	for (N = 1; N < argn - 1 && argv[N][0] == '-'; N += 2) {
+
+		if (strlen(argv[N + 1]) >= READ_FILE_PATH_MAX) {
+
+			ERROR("Too long option argument\n");
+			return 1;
+		}
+
+		if (strcmp(argv[N], "-o") == 0) {
+
+			strcpy(gp->export_file, argv[N + 1]);
+		}
+		else if (strcmp(argv[N], "-s") == 0) {
+
+			if (sscanf(argv[N + 1], "%dx%d", &gp->export_size_x,
+					&gp->export_size_y) != 2
+					|| gp->export_size_x < GP_MIN_SIZE_X
+					|| gp->export_size_y < GP_MIN_SIZE_Y) {
+
+				ERROR("Invalid size \"%s\"\n", argv[N + 1]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[N], "-p") == 0
+				&& strlen(argv[N + 1]) < PLOT_STRING_MAX) {
+
+			strcpy(gp->export_pages, argv[N + 1]);
+		}
+		else if (strcmp(argv[N], "-j") == 0) {
+
+			if (sscanf(argv[N + 1], "%d", &gp->export_threads) != 1
+					|| gp->export_threads < 1) {
+
+				ERROR("Invalid number of threads \"%s\"\n", argv[N + 1]);
+				return 1;
+			}
+		}
+		else {
+			ERROR("Unknown option \"%s\"\n", argv[N]);
+			return 1;
+		}
+	}
+
+	/* Options are followed by usual arguments.
+	 * */
+	argn -= N - 1;
+	argv += N - 1;
+
+	if (gp->export_file[0] != 0) {
+
+		SDL_Init(0);
+	}
+	else {
+		SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+
+		gp->event_async = async_init();
+	}
+
 	TTF_Init();
 	IMG_Init(IMG_INIT_PNG);
 
@@ -3553,20 +4345,35 @@ int main(int argn, char *argv[])
 		return 1;
 	}
 
-	gp->window = SDL_CreateWindow("GP", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-			rd->window_size_x, rd->window_size_y, SDL_WINDOW_RESIZABLE);
+	if (gp->export_file[0] != 0) {
 
-	SDL_SetWindowMinimumSize(gp->window, GP_MIN_SIZE_X, GP_MIN_SIZE_Y);
-	SDL_StopTextInput();
+		if (gp->export_size_x == 0) {
 
-	gp->fb = SDL_GetWindowSurface(gp->window);
-	gp->surface = SDL_CreateRGBSurfaceWithFormat(0, gp->fb->w,
-			gp->fb->h, 32, SDL_PIXELFORMAT_XRGB8888);
+			gp->export_size_x = rd->window_size_x;
+			gp->export_size_y = rd->window_size_y;
+		}
+
+		gp->surface = SDL_CreateRGBSurfaceWithFormat(0, gp->export_size_x,
+				gp->export_size_y, 32, SDL_PIXELFORMAT_XRGB8888);
+	}
+	else {
+		gp->window = SDL_CreateWindow("GP", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+				rd->window_size_x, rd->window_size_y, SDL_WINDOW_RESIZABLE);
+
+		SDL_SetWindowMinimumSize(gp->window, GP_MIN_SIZE_X, GP_MIN_SIZE_Y);
+		SDL_StopTextInput();
+
+		gp->fb = SDL_GetWindowSurface(gp->window);
+		gp->surface = SDL_CreateRGBSurfaceWithFormat(0, gp->fb->w,
+				gp->fb->h, 32, SDL_PIXELFORMAT_XRGB8888);
+	}
 
 	gpFontLayout(gp);
+	gpFramePeriod(gp);
 
 	gp->stat = GP_IDLE;
 	gp->active = 1;
+	gp->input_clock = SDL_GetTicks();
 
 	gp->colorscheme = rd->colorscheme;
 	gp->language = rd->language;
@@ -3584,28 +4391,61 @@ int main(int argn, char *argv[])
 	schemeFill(sch, gp->colorscheme);
 
 	gpMakePageMenu(gp);
-	readSelectPage(rd, 1);
+
+	if (gp->export_file[0] != 0) {
+
+		gp->done = 1;
+
+		rc = gpExportBatch(gp);
+	}
+	else {
+		readSelectPage(rd, 1);
+	}
 
 	while (gp->done != 1) {
 
-		gp->clock = SDL_GetTicks();
+		N = gpWaitTimeout(gp);
 
-		while (SDL_PollEvent(&gp->ev) != 0) {
+		while (((N != 0) ? SDL_WaitEventTimeout(&gp->ev, N)
+					: SDL_PollEvent(&gp->ev)) != 0) {
 
-			gpEventHandle(gp);
+			if (gp->ev.type != gp->event_async) {
+
+				gpEventHandle(gp);
+
+				gp->input_clock = SDL_GetTicks();
+			}
 
 			gp->active = 1;
+
+			N = 0;
 		}
 
+		gp->clock = SDL_GetTicks();
+		tFRAME = SDL_GetPerformanceCounter();
+
+		gp->reading = 0;
+
+		readProjection(rd);
+
 		if (rd->files_N != 0) {
 
+			gpReadBudget(gp);
+
+			tREAD = SDL_GetPerformanceCounter();
+
 			if (readUpdate(rd) != 0) {
 
 				gp->active = 1;
+				gp->reading = 1;
 			}
+
+			gp->t_read = gpElapsedUs(tREAD);
 		}
 		else {
 			plotAxisScaleLock(pl, 0);
+
+			gp->t_read = 0;
 		}
 
 		if (gp->i_show_fps != 0) {
@@ -3634,14 +4474,11 @@ int main(int argn, char *argv[])
 
 		if (gp->unfinished != 0) {
 
-			SDL_LockSurface(gp->surface);
-
-			drawClearSurface(gp->dw, gp->surface, pl->sch->plot_background);
-
-			SDL_UnlockSurface(gp->surface);
+			gpDrawBudget(gp);
 
 			plotLayout(pl);
 			plotAxisScaleDefault(pl);
+			plotDrawLayer(pl, gp->surface);
 
 			if (gp->stat == GP_RANGE_SELECT) {
 
@@ -3655,33 +4492,37 @@ int main(int argn, char *argv[])
 				gpDrawBoxLight(gp->surface, gp);
 			}
 
-			plotDraw(pl, gp->surface);
-
-			if (gp->stat == GP_RANGE_SELECT) {
-
-				gpDrawRangeSelect(gp->surface, gp);
-			}
-			else if (gp->stat == GP_BOX_SELECT) {
-
-				gpDrawBoxSelect(gp->surface, gp);
-			}
-
 			if (gp->hover_box) {
 
 				drawFillRect(gp->surface, pl->screen.min_x,
 						pl->screen.min_y - gp->layout_page_box,
 						pl->screen.max_x, pl->screen.min_y,
 						pl->sch->plot_hovered);
+
+				cb.min_x = pl->screen.min_x;
+				cb.min_y = pl->screen.min_y - gp->layout_page_box;
+				cb.max_x = pl->screen.max_x;
+				cb.max_y = pl->screen.min_y;
+
+				gpDamage(gp, &cb);
 			}
 
 			gpTextLeftCrop(gp->pl, gp->sbuf[1], rd->page[rd->page_N].title,
 					gp->layout_menu_page_margin);
 
 			sprintf(gp->sbuf[0], "%3d. %s", rd->page_N, gp->sbuf[1]);
+			gpPlotTitle(pl, gp->sbuf[0]);
+
+			plotDraw(pl, gp->surface);
+
+			if (gp->stat == GP_RANGE_SELECT) {
+
+				gpDrawRangeSelect(gp->surface, gp);
+			}
+			else if (gp->stat == GP_BOX_SELECT) {
 
-			drawText(gp->dw, gp->surface, pl->font, (pl->screen.min_x + pl->screen.max_x) / 2,
-					pl->screen.min_y + gp->layout_page_title_offset, gp->sbuf[0],
-					TEXT_CENTERED, sch->plot_text);
+				gpDrawBoxSelect(gp->surface, gp);
+			}
 
 			menuDraw(mu, gp->surface);
 			editDraw(ed, gp->surface);
@@ -3695,10 +4536,22 @@ int main(int argn, char *argv[])
 				drawText(gp->dw, gp->surface, pl->font, pl->screen.max_x - (W + 5),
 						pl->screen.min_y + gp->layout_page_title_offset,
 						gp->sbuf[0], TEXT_CENTERED_ON_Y, 0xFF5533);
+
+				cb.min_x = pl->screen.max_x - (W + 5);
+				cb.min_y = pl->screen.min_y + gp->layout_page_title_offset - N;
+				cb.max_x = pl->screen.max_x;
+				cb.max_y = pl->screen.min_y + gp->layout_page_title_offset + N;
+
+				gpDamage(gp, &cb);
 			}
 
-			SDL_BlitSurface(gp->surface, NULL, gp->fb, NULL);
-			SDL_UpdateWindowSurface(gp->window);
+			gpPresent(gp);
+
+			/* Everything besides reading and trial drawing is
+			 * taken as frame overhead.
+			 * */
+			tUS = gpElapsedUs(tFRAME) - gp->t_read - pl->draw_spent;
+			gp->t_overhead += (tUS - gp->t_overhead) / 4;
 
 			gpFPSUpdate(gp);
 
@@ -3707,14 +4560,18 @@ int main(int argn, char *argv[])
 				gp->unfinished = 0;
 			}
 		}
-		else {
-			SDL_Delay(10);
-		}
 
 		gpTakeScreen(gp);
 		gpYankScreen(gp);
 	}
 
+	while (SDL_AtomicGet(&gp->screen_busy) != 0) {
+
+		/* Wait for screenshots that are still being encoded.
+		 * */
+		SDL_Delay(10);
+	}
+
 	plotClean(pl);
 	readClean(rd);
 	menuClean(mu);
@@ -3727,6 +4584,6 @@ int main(int argn, char *argv[])
 
 	SDL_Quit();
 
-	return 0;
+	return rc;
 }
 
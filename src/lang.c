@@ -137,6 +137,10 @@ void langFill(lang_t *la, int lang)
 			"    Dot   2p\0"
 			"    Dot   4p\0"
 			"    Dot   6p\0"
+			"    Density 1p\0"
+			"    Density 2p\0"
+			"    Density 4p\0"
+			"    Density 6p\0"
 
 			"\0";
 
@@ -301,6 +305,10 @@ void langFill(lang_t *la, int lang)
 			"    Точка  2п\0"
 			"    Точка  4п\0"
 			"    Точка  6п\0"
+			"    Плотность  1п\0"
+			"    Плотность  2п\0"
+			"    Плотность  4п\0"
+			"    Плотность  6п\0"
 
 			"\0";
 
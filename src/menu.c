@@ -541,6 +541,9 @@ void menuDraw(menu_t *mu, SDL_Surface *surface)
 
 	colType_t		iCol;
 
+	mu->damage.min_x = 0;
+	mu->damage.max_x = -1;
+
 	if (mu->raised == 0)
 		return ;
 
@@ -549,6 +552,11 @@ void menuDraw(menu_t *mu, SDL_Surface *surface)
 	baseY = mu->box_Y + mu->size_Y;
 	baseY += (mu->fuzzy[0] != 0) ? mu->layout_height : 0;
 
+	mu->damage.min_x = mu->box_X;
+	mu->damage.min_y = mu->box_Y;
+	mu->damage.max_x = mu->box_X + mu->size_X;
+	mu->damage.max_y = baseY;
+
 	drawFillRect(surface, mu->box_X, mu->box_Y, mu->box_X + mu->size_X,
 			baseY, mu->sch->menu_background);
 
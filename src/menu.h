@@ -67,6 +67,10 @@ typedef struct {
 	TTF_Font		*font;
 	clipBox_t		screen;
 
+	/* Region that was drawn over by the last menuDraw.
+	 * */
+	clipBox_t		damage;
+
 	char			fuzzy[MENU_FUZZY_SIZE];
 
 	int			layout_height;
@@ -78,6 +78,8 @@ plot_t *plotAlloc(draw_t *dw, scheme_t *sch)
 	for (N = 0; N < PLOT_FIGURE_MAX; ++N)
 		pl->draw[N].list_self = -1;
 
+	pl->draw_budget = 20;
+
 	pl->layout_font_long = 11;
 	pl->layout_border = 5;
 	pl->layout_tick_tooth = 5;
@@ -116,12 +118,63 @@ plotSketchFree(plot_t *pl)
 	}
 }
 
+static void
+plotOverlayFree(plot_t *pl)
+{
+	int		N;
+
+	for (N = 0; N < 2; ++N) {
+
+		if (pl->overlay[N] != NULL) {
+
+			SDL_FreeSurface(pl->overlay[N]);
+
+			pl->overlay[N] = NULL;
+		}
+	}
+
+	pl->overlay_valid = 0;
+}
+
+static void
+plotDensityFree(plot_t *pl)
+{
+	int		N;
+
+	for (N = 0; N < PLOT_FIGURE_MAX; ++N) {
+
+		if (pl->draw[N].density != NULL) {
+
+			free(pl->draw[N].density);
+			free(pl->draw[N].density_todraw);
+
+			pl->draw[N].density = NULL;
+			pl->draw[N].density_todraw = NULL;
+		}
+
+		pl->draw[N].density_len = 0;
+		pl->draw[N].density_peak = -1.f;
+		pl->draw[N].density_todraw_peak = 0.f;
+	}
+}
+
 void plotClean(plot_t *pl)
 {
 	int		dN;
 
 	drawPixmapClean(pl->dw);
+	drawFlushClean(pl->dw);
+	drawTextCacheClean(pl->dw);
+
+	if (pl->layer != NULL) {
+
+		SDL_FreeSurface(pl->layer);
+	}
+
+	plotOverlayFree(pl);
+
 	plotSketchFree(pl);
+	plotDensityFree(pl);
 
 	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
 
@@ -146,6 +199,8 @@ plotFontLayout(plot_t *pl)
 
 void plotFontDefault(plot_t *pl, int ttfnum, int ptsize, int style)
 {
+	drawTextCacheClean(pl->dw);
+
 	if (pl->font != NULL) {
 
 		TTF_CloseFont(pl->font);
@@ -169,6 +224,8 @@ void plotFontDefault(plot_t *pl, int ttfnum, int ptsize, int style)
 
 	TTF_SetFontStyle(pl->font, style);
 
+	pl->layer_valid = 0;
+	pl->overlay_valid = 0;
 	pl->layout_font_ttf = ttfnum;
 	pl->layout_font_pt = ptsize;
 
@@ -177,6 +234,8 @@ void plotFontDefault(plot_t *pl, int ttfnum, int ptsize, int style)
 
 void plotFontOpen(plot_t *pl, const char *file, int ptsize, int style)
 {
+	drawTextCacheClean(pl->dw);
+
 	if (pl->font != NULL) {
 
 		TTF_CloseFont(pl->font);
@@ -192,8 +251,16 @@ void plotFontOpen(plot_t *pl, const char *file, int ptsize, int style)
 		return ;
 	}
 
+	if (file != pl->layout_font_file) {
+
+		strncpy(pl->layout_font_file, file, sizeof(pl->layout_font_file) - 1);
+		pl->layout_font_file[sizeof(pl->layout_font_file) - 1] = 0;
+	}
+
 	TTF_SetFontStyle(pl->font, style);
 
+	pl->layer_valid = 0;
+	pl->overlay_valid = 0;
 	pl->layout_font_ttf = 0;
 	pl->layout_font_pt = ptsize;
 
@@ -348,51 +415,63 @@ plotDataCacheGetNode(plot_t *pl, int dN, int kN)
 }
 
 static void
-plotDataCacheFetch(plot_t *pl, int dN, int kN)
+plotDataCacheCompress(plot_t *pl, int dN, int xN)
 {
-	int		xN, kNZ, lzLEN;
+	int		kNZ, lzLEN;
 
-	xN = plotDataCacheGetNode(pl, dN, kN);
+	kNZ = pl->data[dN].cache[xN].chunk_N;
 
-	if (pl->data[dN].cache[xN].raw != NULL) {
+	lzLEN = LZ4_compressBound(pl->data[dN].chunk_bSIZE);
 
-		kNZ = pl->data[dN].cache[xN].chunk_N;
+	if (pl->data[dN].compress[kNZ].raw != NULL) {
 
-		if (pl->data[dN].cache[xN].dirty != 0) {
+		free(pl->data[dN].compress[kNZ].raw);
+	}
 
-			lzLEN = LZ4_compressBound(pl->data[dN].chunk_bSIZE);
+	pl->data[dN].compress[kNZ].raw = (void *) malloc(lzLEN);
 
-			if (pl->data[dN].compress[kNZ].raw != NULL) {
+	if (pl->data[dN].compress[kNZ].raw == NULL) {
 
-				free(pl->data[dN].compress[kNZ].raw);
-			}
+		ERROR("Unable to allocate LZ4 memory of %i dataset\n", dN);
+	}
 
-			pl->data[dN].compress[kNZ].raw = (void *) malloc(lzLEN);
+	lzLEN = LZ4_compress_default(
+			(const char *) pl->data[dN].cache[xN].raw,
+			(char *) pl->data[dN].compress[kNZ].raw,
+			pl->data[dN].chunk_bSIZE, lzLEN);
 
-			if (pl->data[dN].compress[kNZ].raw == NULL) {
+	if (lzLEN > 0) {
 
-				ERROR("Unable to allocate LZ4 memory of %i dataset\n", dN);
-			}
+		pl->data[dN].compress[kNZ].raw =
+			realloc(pl->data[dN].compress[kNZ].raw, lzLEN);
+		pl->data[dN].compress[kNZ].length = lzLEN;
+	}
+	else {
+		ERROR("Unable to compress the chunk of %i dataset\n", dN);
 
-			lzLEN = LZ4_compress_default(
-					(const char *) pl->data[dN].cache[xN].raw,
-					(char *) pl->data[dN].compress[kNZ].raw,
-					pl->data[dN].chunk_bSIZE, lzLEN);
+		free(pl->data[dN].compress[kNZ].raw);
 
-			if (lzLEN > 0) {
+		pl->data[dN].compress[kNZ].raw = NULL;
+		pl->data[dN].compress[kNZ].length = 0;
+	}
 
-				pl->data[dN].compress[kNZ].raw =
-					realloc(pl->data[dN].compress[kNZ].raw, lzLEN);
-				pl->data[dN].compress[kNZ].length = lzLEN;
-			}
-			else {
-				ERROR("Unable to compress the chunk of %i dataset\n", dN);
+	pl->data[dN].cache[xN].dirty = 0;
+}
+
+static void
+plotDataCacheFetch(plot_t *pl, int dN, int kN)
+{
+	int		xN, kNZ, lzLEN;
 
-				free(pl->data[dN].compress[kNZ].raw);
+	xN = plotDataCacheGetNode(pl, dN, kN);
 
-				pl->data[dN].compress[kNZ].raw = NULL;
-				pl->data[dN].compress[kNZ].length = 0;
-			}
+	if (pl->data[dN].cache[xN].raw != NULL) {
+
+		kNZ = pl->data[dN].cache[xN].chunk_N;
+
+		if (pl->data[dN].cache[xN].dirty != 0) {
+
+			plotDataCacheCompress(pl, dN, xN);
 		}
 
 		pl->data[dN].raw[kNZ] = NULL;
@@ -1311,6 +1390,13 @@ void plotDataSubtractClean(plot_t *pl)
 {
 	int		dN, N;
 
+	if (pl->data_shared != 0) {
+
+		/* Subtract columns are owned by original plot.
+		 * */
+		return ;
+	}
+
 	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
 
 		if (pl->data[dN].column_N != 0) {
@@ -1426,6 +1512,166 @@ void plotDataClean(plot_t *pl, int dN)
 	}
 }
 
+plot_t *plotClone(plot_t *pl, draw_t *dw)
+{
+	plot_t		*wp;
+	int		*map, dN, N, len, style;
+
+	wp = malloc(sizeof(plot_t));
+
+	if (wp == NULL) {
+
+		ERROR("No memory allocated for plot clone\n");
+		return NULL;
+	}
+
+	if (pl->lz4_compress != 0) {
+
+		/* Compressed chunks are shared so we flush dirty cache
+		 * first. The clone gets its own empty cache.
+		 * */
+		for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+			if (pl->data[dN].column_N == 0)
+				continue;
+
+			for (N = 0; N < PLOT_CHUNK_CACHE; ++N) {
+
+				if (		pl->data[dN].cache[N].raw != NULL
+						&& pl->data[dN].cache[N].dirty != 0) {
+
+					plotDataCacheCompress(pl, dN, N);
+				}
+			}
+		}
+	}
+
+	memcpy(wp, pl, sizeof(plot_t));
+
+	/* The clone shares dataset rows with original plot but has its own
+	 * drawing state. Subtract columns must be computed in advance.
+	 * */
+	wp->dw = dw;
+	wp->font = NULL;
+	wp->layer = NULL;
+	wp->layer_valid = 0;
+	wp->overlay[0] = NULL;
+	wp->overlay[1] = NULL;
+	wp->overlay_valid = 0;
+	wp->data_shared = 1;
+
+	for (N = 0; N < PLOT_SKETCH_MAX; ++N)
+		wp->sketch[N].chunk = NULL;
+
+	for (N = 0; N < PLOT_FIGURE_MAX; ++N) {
+
+		wp->draw[N].density = NULL;
+		wp->draw[N].density_todraw = NULL;
+		wp->draw[N].density_len = 0;
+		wp->draw[N].density_peak = -1.f;
+	}
+
+	plotSketchClean(wp);
+
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (pl->lz4_compress != 0 && pl->data[dN].column_N != 0) {
+
+			for (N = 0; N < PLOT_CHUNK_CACHE; ++N) {
+
+				wp->data[dN].cache[N].raw = NULL;
+				wp->data[dN].cache[N].chunk_N = -1;
+				wp->data[dN].cache[N].dirty = 0;
+			}
+
+			for (N = 0; N < PLOT_CHUNK_MAX; ++N)
+				wp->data[dN].raw[N] = NULL;
+
+			wp->data[dN].cache_ID = 0;
+		}
+
+		if (pl->data[dN].map != NULL) {
+
+			len = pl->data[dN].column_N + PLOT_SUBTRACT + 1;
+			map = (int *) malloc(sizeof(int) * len);
+
+			if (map != NULL) {
+
+				memcpy(map, pl->data[dN].map - 1, sizeof(int) * len);
+				wp->data[dN].map = map + 1;
+			}
+			else {
+				ERROR("No memory allocated for %i map\n", dN);
+				wp->data[dN].map = NULL;
+			}
+		}
+	}
+
+	style = (pl->font != NULL) ? TTF_GetFontStyle(pl->font) : TTF_STYLE_NORMAL;
+
+	if (pl->layout_font_ttf != 0) {
+
+		plotFontDefault(wp, pl->layout_font_ttf, pl->layout_font_pt, style);
+	}
+	else {
+		plotFontOpen(wp, pl->layout_font_file, pl->layout_font_pt, style);
+	}
+
+	if (wp->font == NULL) {
+
+		plotCloneClean(wp);
+		return NULL;
+	}
+
+	if (pl->font != NULL) {
+
+		TTF_SetFontHinting(wp->font, TTF_GetFontHinting(pl->font));
+	}
+
+	return wp;
+}
+
+void plotCloneClean(plot_t *pl)
+{
+	int		dN, N;
+
+	drawPixmapClean(pl->dw);
+	drawFlushClean(pl->dw);
+	drawTextCacheClean(pl->dw);
+
+	if (pl->layer != NULL) {
+
+		SDL_FreeSurface(pl->layer);
+	}
+
+	plotOverlayFree(pl);
+
+	if (pl->font != NULL) {
+
+		TTF_CloseFont(pl->font);
+	}
+
+	plotSketchFree(pl);
+	plotDensityFree(pl);
+
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (pl->lz4_compress != 0 && pl->data[dN].column_N != 0) {
+
+			for (N = 0; N < PLOT_CHUNK_CACHE; ++N) {
+
+				if (pl->data[dN].cache[N].raw != NULL)
+					free(pl->data[dN].cache[N].raw);
+			}
+		}
+
+		if (pl->data[dN].map != NULL)
+			free(pl->data[dN].map - 1);
+	}
+
+	free(pl);
+}
+
 static int
 plotDataRangeCacheGetNode(plot_t *pl, int dN, int cN)
 {
@@ -2078,7 +2324,20 @@ void plotAxisScaleAutoCond(plot_t *pl, int aN, int bN)
 				else
 					break;
 
-				if (bN == -1) {
+				if (		pl->figure[fN].axis_X == aN
+						&& pl->figure[fN].persist == FIGURE_PERSIST_PERIOD) {
+
+					min = 0.;
+					max = pl->figure[fN].persist_period;
+				}
+				else if (	pl->figure[fN].axis_X == aN
+						&& pl->figure[fN].persist == FIGURE_PERSIST_TRIGGER
+						&& pl->draw[fN].persist_span > 0.) {
+
+					min = 0.;
+					max = pl->draw[fN].persist_span;
+				}
+				else if (bN == -1) {
 
 					plotDataRangeGet(pl, dN, cN, &min, &max);
 				}
@@ -2736,10 +2995,12 @@ void plotFigureAdd(plot_t *pl, int fN, int dN, int nX, int nY, int aX, int aY, c
 	}
 
 	pl->draw[fN].sketch = SKETCH_FINISHED;
+	pl->draw[fN].density_todraw_peak = 0.f;
 
 	pl->figure[fN].busy = 1;
 	pl->figure[fN].hidden = 0;
 	pl->figure[fN].drawing = pl->default_drawing;
+	pl->figure[fN].persist = FIGURE_PERSIST_DISABLED;
 	pl->figure[fN].width = pl->default_width;
 	pl->figure[fN].data_N = dN;
 	pl->figure[fN].column_X = nX;
@@ -3172,11 +3433,37 @@ plotGetSubtractScaleByMatch(plot_t *pl, int dN, int cN, double scale, double off
 	return rN;
 }
 
+static int
+plotGetSubtractBinaryByMatch(plot_t *pl, int dN, int opSUB, int cN_1, int cN_2)
+{
+	int		sN, rN = -1;
+
+	for (sN = 0; sN < PLOT_SUBTRACT; ++sN) {
+
+		if (pl->data[dN].sub[sN].busy == opSUB
+				&& pl->data[dN].sub[sN].op.binary.column_1 == cN_1
+				&& pl->data[dN].sub[sN].op.binary.column_2 == cN_2) {
+
+			rN = sN;
+			break;
+		}
+	}
+
+	return rN;
+}
+
 static int
 plotGetFreeSubtract(plot_t *pl, int dN)
 {
 	int		sN, rN = -1;
 
+	if (pl->data_shared != 0) {
+
+		/* We are not allowed to write into shared rows.
+		 * */
+		return -1;
+	}
+
 	for (sN = 0; sN < PLOT_SUBTRACT; ++sN) {
 
 		if (pl->data[dN].sub[sN].busy == 0) {
@@ -3310,19 +3597,24 @@ int plotGetSubtractBinary(plot_t *pl, int dN, int opSUB, int cN_1, int cN_2)
 		return -1;
 	}
 
-	sN = plotGetFreeSubtract(pl, dN);
+	sN = plotGetSubtractBinaryByMatch(pl, dN, opSUB, cN_1, cN_2);
 
 	if (sN == -1) {
 
-		ERROR("Unable to get free subtract\n");
-		return -1;
-	}
+		sN = plotGetFreeSubtract(pl, dN);
 
-	pl->data[dN].sub[sN].busy = opSUB;
-	pl->data[dN].sub[sN].op.binary.column_1 = cN_1;
-	pl->data[dN].sub[sN].op.binary.column_2 = cN_2;
+		if (sN == -1) {
 
-	plotDataSubtract(pl, dN, sN);
+			ERROR("Unable to get free subtract\n");
+			return -1;
+		}
+
+		pl->data[dN].sub[sN].busy = opSUB;
+		pl->data[dN].sub[sN].op.binary.column_1 = cN_1;
+		pl->data[dN].sub[sN].op.binary.column_2 = cN_2;
+
+		plotDataSubtract(pl, dN, sN);
+	}
 
 	cN = sN + pl->data[dN].column_N;
 
@@ -4625,75 +4917,257 @@ void plotSketchClean(plot_t *pl)
 	pl->sketch_list_current = -1;
 	pl->sketch_list_current_end = -1;
 
-	for (N = 0; N < PLOT_FIGURE_MAX; ++N)
+	for (N = 0; N < PLOT_FIGURE_MAX; ++N) {
+
 		pl->draw[N].list_self = -1;
+		pl->draw[N].density_todraw_peak = 0.f;
+	}
 
 	pl->draw_in_progress = 0;
 }
 
-static void
-plotDrawPalette(plot_t *pl)
+static int
+plotDensitySetUp(plot_t *pl, int fN, const double map[4], int reset)
 {
-	draw_t			*dw = pl->dw;
-	scheme_t		*sch = pl->sch;
-	colType_t		*palette;
+	int		len;
 
-	palette = dw->palette;
+	len = pl->dw->pixmap.yspan * pl->dw->pixmap.h;
 
-	palette[0] = sch->plot_background;
-	palette[1] = sch->plot_figure[0];
-	palette[2] = sch->plot_figure[1];
-	palette[3] = sch->plot_figure[2];
-	palette[4] = sch->plot_figure[3];
-	palette[5] = sch->plot_figure[4];
-	palette[6] = sch->plot_figure[5];
-	palette[7] = sch->plot_figure[6];
-	palette[8] = sch->plot_figure[7];
-	palette[9] = sch->plot_hidden;
-	palette[10] = sch->plot_text;
-}
+	if (pl->draw[fN].density_len != len) {
 
-static void
-plotDrawFigureTrial(plot_t *pl, int fN)
-{
-	const fval_t	*row;
-	double		scale_X, scale_Y, offset_X, offset_Y, im_MIN, im_MAX;
-	double		X, Y, last_X, last_Y, im_X, im_Y, last_im_X, last_im_Y;
-	int		dN, rN, xN, yN, xNR, yNR, aN, bN, id_N, top_N, kN, kN_cached;
-	int		job, skipped, line, rc, ncolor, fdrawing, fwidth;
+		if (pl->draw[fN].density != NULL) {
 
-	ncolor = (pl->figure[fN].hidden != 0) ? 9 : fN + 1;
+			free(pl->draw[fN].density);
+			free(pl->draw[fN].density_todraw);
+		}
 
-	fdrawing = pl->figure[fN].drawing;
-	fwidth = pl->figure[fN].width;
+		pl->draw[fN].density = (float *) malloc(sizeof(float) * len);
+		pl->draw[fN].density_todraw = (float *) malloc(sizeof(float) * len);
 
-	dN = pl->figure[fN].data_N;
-	xN = pl->figure[fN].column_X;
-	yN = pl->figure[fN].column_Y;
+		if (		pl->draw[fN].density == NULL
+				|| pl->draw[fN].density_todraw == NULL) {
 
-	xNR = plotDataRangeCacheFetch(pl, dN, xN);
-	yNR = plotDataRangeCacheFetch(pl, dN, yN);
+			ERROR("Unable to allocate memory of %i density map\n", fN);
 
-	aN = pl->figure[fN].axis_X;
-	scale_X = pl->axis[aN].scale;
-	offset_X = pl->axis[aN].offset;
+			free(pl->draw[fN].density);
+			free(pl->draw[fN].density_todraw);
 
-	if (pl->axis[aN].slave != 0) {
+			pl->draw[fN].density = NULL;
+			pl->draw[fN].density_todraw = NULL;
+			pl->draw[fN].density_len = 0;
 
-		bN = pl->axis[aN].slave_N;
-		scale_X *= pl->axis[bN].scale;
-		offset_X = offset_X * pl->axis[bN].scale + pl->axis[bN].offset;
+			return -1;
+		}
+
+		pl->draw[fN].density_len = len;
+		pl->draw[fN].density_peak = -1.f;
+		pl->draw[fN].density_todraw_peak = 0.f;
 	}
 
-	aN = pl->figure[fN].axis_Y;
-	scale_Y = pl->axis[aN].scale;
-	offset_Y = pl->axis[aN].offset;
+	if (		reset != 0
+			|| pl->draw[fN].density_peak < 0.f
+			|| pl->draw[fN].density_map[0] != map[0]
+			|| pl->draw[fN].density_map[1] != map[1]
+			|| pl->draw[fN].density_map[2] != map[2]
+			|| pl->draw[fN].density_map[3] != map[3]) {
 
-	if (pl->axis[aN].slave != 0) {
+		/* The hit counts are only valid for one image transform so we
+		 * start the accumulation over when the view was changed.
+		 * */
+		memset(pl->draw[fN].density, 0, sizeof(float) * len);
 
-		bN = pl->axis[aN].slave_N;
-		scale_Y *= pl->axis[bN].scale;
-		offset_Y = offset_Y * pl->axis[bN].scale + pl->axis[bN].offset;
+		pl->draw[fN].density_map[0] = map[0];
+		pl->draw[fN].density_map[1] = map[1];
+		pl->draw[fN].density_map[2] = map[2];
+		pl->draw[fN].density_map[3] = map[3];
+		pl->draw[fN].density_peak = 0.f;
+
+		return 1;
+	}
+
+	return 0;
+}
+
+static void
+plotDensityFinished(plot_t *pl, int fN)
+{
+	float		*density;
+
+	density = pl->draw[fN].density_todraw;
+
+	pl->draw[fN].density_todraw = pl->draw[fN].density;
+	pl->draw[fN].density = density;
+
+	pl->draw[fN].density_todraw_peak = pl->draw[fN].density_peak;
+	pl->draw[fN].density_todraw_map[0] = pl->draw[fN].density_map[0];
+	pl->draw[fN].density_todraw_map[1] = pl->draw[fN].density_map[1];
+	pl->draw[fN].density_todraw_map[2] = pl->draw[fN].density_map[2];
+	pl->draw[fN].density_todraw_map[3] = pl->draw[fN].density_map[3];
+
+	pl->draw[fN].density_peak = -1.f;
+}
+
+static void
+plotPersistResume(plot_t *pl, int fN)
+{
+	int		dN, lN, rN, id_N, tN, sk_N;
+
+	dN = pl->figure[fN].data_N;
+	lN = pl->data[dN].length_N;
+
+	tN = pl->data[dN].tail_N - pl->data[dN].head_N;
+	tN = (tN < 0) ? tN + lN : tN;
+
+	sk_N = pl->draw[fN].persist_id_N - pl->data[dN].id_N;
+
+	if (sk_N > tN) {
+
+		/* Dataset was reloaded so drop the accumulated segments.
+		 * */
+		pl->draw[fN].persist_conf[0] = -1;
+	}
+
+	sk_N = (sk_N < 0 || sk_N > tN) ? 0 : sk_N;
+
+	rN = pl->data[dN].head_N;
+	id_N = pl->data[dN].id_N;
+
+	plotDataSkip(pl, dN, &rN, &id_N, sk_N);
+
+	pl->draw[fN].rN = rN;
+	pl->draw[fN].id_N = id_N;
+}
+
+static int
+plotPersistSetUp(plot_t *pl, int fN, const double map[4])
+{
+	int		conf[7], dN, reset, rc;
+
+	dN = pl->figure[fN].data_N;
+
+	conf[0] = dN;
+	conf[1] = pl->figure[fN].column_X;
+	conf[2] = pl->figure[fN].column_Y;
+	conf[3] = pl->figure[fN].drawing;
+	conf[4] = pl->figure[fN].width;
+	conf[5] = pl->figure[fN].persist;
+	conf[6] = pl->figure[fN].persist_column;
+
+	reset = (	   memcmp(conf, pl->draw[fN].persist_conf, sizeof(conf)) != 0
+			|| pl->draw[fN].persist_args[0] != pl->figure[fN].persist_period
+			|| pl->draw[fN].persist_args[1] != pl->figure[fN].persist_decay) ? 1 : 0;
+
+	if (reset != 0) {
+
+		memcpy(pl->draw[fN].persist_conf, conf, sizeof(conf));
+
+		pl->draw[fN].persist_args[0] = pl->figure[fN].persist_period;
+		pl->draw[fN].persist_args[1] = pl->figure[fN].persist_decay;
+	}
+
+	rc = plotDensitySetUp(pl, fN, map, reset);
+
+	if (rc > 0) {
+
+		pl->draw[fN].rN = pl->data[dN].head_N;
+		pl->draw[fN].id_N = pl->data[dN].id_N;
+		pl->draw[fN].line = 0;
+
+		pl->draw[fN].persist_origin = fp_nan();
+		pl->draw[fN].persist_trigger = 0.;
+		pl->draw[fN].persist_weight = 1.;
+		pl->draw[fN].persist_span = 0.;
+	}
+
+	return rc;
+}
+
+static void
+plotPersistNormalize(plot_t *pl, int fN)
+{
+	float		*density, *lend, weight;
+
+	/* Segment weight grows with each new segment instead of all the
+	 * buffer being decayed. Here we scale it back to avoid an overflow.
+	 * */
+	weight = (float) (1. / pl->draw[fN].persist_weight);
+
+	density = pl->draw[fN].density;
+	lend = density + pl->draw[fN].density_len;
+
+	while (density < lend) {
+
+		*density++ *= weight;
+	}
+
+	pl->draw[fN].density_peak *= weight;
+	pl->draw[fN].persist_weight = 1.;
+}
+
+static void
+plotDrawPalette(plot_t *pl)
+{
+	draw_t			*dw = pl->dw;
+	scheme_t		*sch = pl->sch;
+	colType_t		*palette;
+
+	palette = dw->palette;
+
+	palette[0] = sch->plot_background;
+	palette[1] = sch->plot_figure[0];
+	palette[2] = sch->plot_figure[1];
+	palette[3] = sch->plot_figure[2];
+	palette[4] = sch->plot_figure[3];
+	palette[5] = sch->plot_figure[4];
+	palette[6] = sch->plot_figure[5];
+	palette[7] = sch->plot_figure[6];
+	palette[8] = sch->plot_figure[7];
+	palette[9] = sch->plot_hidden;
+	palette[10] = sch->plot_text;
+}
+
+static void
+plotDrawFigureTrial(plot_t *pl, int fN)
+{
+	const fval_t	*row;
+	double		scale_X, scale_Y, offset_X, offset_Y, im_MIN, im_MAX;
+	double		X, Y, last_X, last_Y, im_X, im_Y, last_im_X, last_im_Y, map[4];
+	int		dN, rN, xN, yN, xNR, yNR, aN, bN, id_N, top_N, kN, kN_cached;
+	int		job, skipped, line, rc, ncolor, fdrawing, fwidth;
+	float		peak;
+
+	ncolor = (pl->figure[fN].hidden != 0) ? 9 : fN + 1;
+
+	fdrawing = pl->figure[fN].drawing;
+	fwidth = pl->figure[fN].width;
+
+	dN = pl->figure[fN].data_N;
+	xN = pl->figure[fN].column_X;
+	yN = pl->figure[fN].column_Y;
+
+	xNR = plotDataRangeCacheFetch(pl, dN, xN);
+	yNR = plotDataRangeCacheFetch(pl, dN, yN);
+
+	aN = pl->figure[fN].axis_X;
+	scale_X = pl->axis[aN].scale;
+	offset_X = pl->axis[aN].offset;
+
+	if (pl->axis[aN].slave != 0) {
+
+		bN = pl->axis[aN].slave_N;
+		scale_X *= pl->axis[bN].scale;
+		offset_X = offset_X * pl->axis[bN].scale + pl->axis[bN].offset;
+	}
+
+	aN = pl->figure[fN].axis_Y;
+	scale_Y = pl->axis[aN].scale;
+	offset_Y = pl->axis[aN].offset;
+
+	if (pl->axis[aN].slave != 0) {
+
+		bN = pl->axis[aN].slave_N;
+		scale_Y *= pl->axis[bN].scale;
+		offset_Y = offset_Y * pl->axis[bN].scale + pl->axis[bN].offset;
 	}
 
 	X = (double) (pl->viewport.max_x - pl->viewport.min_x);
@@ -4704,13 +5178,37 @@ plotDrawFigureTrial(plot_t *pl, int fN)
 	scale_Y *= Y;
 	offset_Y = offset_Y * Y + pl->viewport.max_y;
 
+	if (fdrawing == FIGURE_DRAWING_DENSITY) {
+
+		map[0] = scale_X;
+		map[1] = offset_X;
+		map[2] = scale_Y;
+		map[3] = offset_Y;
+
+		rc = plotDensitySetUp(pl, fN, map, 0);
+
+		if (rc < 0) {
+
+			pl->draw[fN].sketch = SKETCH_FINISHED;
+			return ;
+		}
+		else if (rc != 0) {
+
+			pl->draw[fN].rN = pl->data[dN].head_N;
+			pl->draw[fN].id_N = pl->data[dN].id_N;
+		}
+	}
+
 	rN = pl->draw[fN].rN;
 	id_N = pl->draw[fN].id_N;
 
 	top_N = id_N + (1UL << pl->data[dN].chunk_SHIFT);
 	kN_cached = -1;
 
-	plotSketchDataChunkSetUp(pl, fN);
+	if (fdrawing != FIGURE_DRAWING_DENSITY) {
+
+		plotSketchDataChunkSetUp(pl, fN);
+	}
 
 	if (		fdrawing == FIGURE_DRAWING_LINE
 			|| fdrawing == FIGURE_DRAWING_DASH) {
@@ -4854,78 +5352,437 @@ plotDrawFigureTrial(plot_t *pl, int fN)
 						im_MIN = pl->rcache[xNR].chunk[kN].fmin * scale_X + offset_X;
 						im_MAX = pl->rcache[xNR].chunk[kN].fmax * scale_X + offset_X;
 
-						job = (	   im_MAX < pl->viewport.min_x - 16
-							|| im_MIN > pl->viewport.max_x + 16) ? 0 : job;
-					}
-					else {
-						job = 0;
-					}
-				}
+						job = (	   im_MAX < pl->viewport.min_x - 16
+							|| im_MIN > pl->viewport.max_x + 16) ? 0 : job;
+					}
+					else {
+						job = 0;
+					}
+				}
+
+				if (yNR >= 0 && pl->rcache[yNR].chunk[kN].computed != 0) {
+
+					if (pl->rcache[yNR].chunk[kN].finite != 0) {
+
+						im_MIN = pl->rcache[yNR].chunk[kN].fmin * scale_Y + offset_Y;
+						im_MAX = pl->rcache[yNR].chunk[kN].fmax * scale_Y + offset_Y;
+
+						job = (	   im_MIN < pl->viewport.min_y - 16
+							|| im_MAX > pl->viewport.max_y + 16) ? 0 : job;
+					}
+					else {
+						job = 0;
+					}
+				}
+
+				kN_cached = kN;
+			}
+
+			if (job != 0) {
+
+				row = plotDataGet(pl, dN, &rN);
+
+				if (row == NULL) {
+
+					pl->draw[fN].sketch = SKETCH_FINISHED;
+					break;
+				}
+
+				X = (xN < 0) ? id_N : row[xN];
+				Y = (yN < 0) ? id_N : row[yN];
+
+				im_X = X * scale_X + offset_X;
+				im_Y = Y * scale_Y + offset_Y;
+
+				if (fp_isfinite(im_X) && fp_isfinite(im_Y)) {
+
+					rc = drawDotTrial(pl->dw, &pl->viewport,
+							im_X, im_Y, fwidth,
+							ncolor, 1);
+
+					if (rc != 0) {
+
+						plotSketchDataAdd(pl, fN, X, Y);
+					}
+				}
+
+				id_N++;
+			}
+
+			if (job == 0) {
+
+				plotDataChunkSkip(pl, dN, &rN, &id_N);
+			}
+
+			if (id_N > top_N) {
+
+				pl->draw[fN].sketch = SKETCH_INTERRUPTED;
+				pl->draw[fN].rN = rN;
+				pl->draw[fN].id_N = id_N;
+				break;
+			}
+		}
+		while (1);
+	}
+	else if (fdrawing == FIGURE_DRAWING_DENSITY) {
+
+		do {
+			kN = plotDataChunkN(pl, dN, rN);
+			job = 1;
+
+			if (kN != kN_cached) {
+
+				if (xNR >= 0 && pl->rcache[xNR].chunk[kN].computed != 0) {
+
+					if (pl->rcache[xNR].chunk[kN].finite != 0) {
+
+						im_MIN = pl->rcache[xNR].chunk[kN].fmin * scale_X + offset_X;
+						im_MAX = pl->rcache[xNR].chunk[kN].fmax * scale_X + offset_X;
+
+						job = (	   im_MAX < pl->viewport.min_x - 16
+							|| im_MIN > pl->viewport.max_x + 16) ? 0 : job;
+					}
+					else {
+						job = 0;
+					}
+				}
+
+				if (yNR >= 0 && pl->rcache[yNR].chunk[kN].computed != 0) {
+
+					if (pl->rcache[yNR].chunk[kN].finite != 0) {
+
+						im_MIN = pl->rcache[yNR].chunk[kN].fmin * scale_Y + offset_Y;
+						im_MAX = pl->rcache[yNR].chunk[kN].fmax * scale_Y + offset_Y;
+
+						job = (	   im_MIN < pl->viewport.min_y - 16
+							|| im_MAX > pl->viewport.max_y + 16) ? 0 : job;
+					}
+					else {
+						job = 0;
+					}
+				}
+
+				kN_cached = kN;
+			}
+
+			if (job != 0) {
+
+				row = plotDataGet(pl, dN, &rN);
+
+				if (row == NULL) {
+
+					plotDensityFinished(pl, fN);
+
+					pl->draw[fN].sketch = SKETCH_FINISHED;
+					break;
+				}
+
+				X = (xN < 0) ? id_N : row[xN];
+				Y = (yN < 0) ? id_N : row[yN];
+
+				im_X = X * scale_X + offset_X;
+				im_Y = Y * scale_Y + offset_Y;
+
+				if (fp_isfinite(im_X) && fp_isfinite(im_Y)) {
+
+					peak = drawDensityTrial(pl->dw, &pl->viewport,
+							pl->draw[fN].density,
+							im_X, im_Y, fwidth, 1.f);
+
+					if (peak > pl->draw[fN].density_peak)
+						pl->draw[fN].density_peak = peak;
+				}
+
+				id_N++;
+			}
+
+			if (job == 0) {
+
+				plotDataChunkSkip(pl, dN, &rN, &id_N);
+			}
+
+			if (id_N > top_N) {
+
+				pl->draw[fN].sketch = SKETCH_INTERRUPTED;
+				pl->draw[fN].rN = rN;
+				pl->draw[fN].id_N = id_N;
+				break;
+			}
+		}
+		while (1);
+	}
+}
+
+static void
+plotDrawFigurePersist(plot_t *pl, int fN)
+{
+	const fval_t	*row;
+	double		scale_X, scale_Y, offset_X, offset_Y, map[4];
+	double		X, Y, T, seg, last_im_X, last_im_Y, im_X, im_Y, grow;
+	int		dN, rN, xN, yN, tN, aN, bN, id_N, top_N;
+	int		line, fdrawing, fwidth;
+	float		peak;
+
+	fdrawing = pl->figure[fN].drawing;
+	fwidth = pl->figure[fN].width;
+
+	dN = pl->figure[fN].data_N;
+	xN = pl->figure[fN].column_X;
+	yN = pl->figure[fN].column_Y;
+	tN = pl->figure[fN].persist_column;
+
+	aN = pl->figure[fN].axis_X;
+	scale_X = pl->axis[aN].scale;
+	offset_X = pl->axis[aN].offset;
+
+	if (pl->axis[aN].slave != 0) {
+
+		bN = pl->axis[aN].slave_N;
+		scale_X *= pl->axis[bN].scale;
+		offset_X = offset_X * pl->axis[bN].scale + pl->axis[bN].offset;
+	}
+
+	aN = pl->figure[fN].axis_Y;
+	scale_Y = pl->axis[aN].scale;
+	offset_Y = pl->axis[aN].offset;
+
+	if (pl->axis[aN].slave != 0) {
+
+		bN = pl->axis[aN].slave_N;
+		scale_Y *= pl->axis[bN].scale;
+		offset_Y = offset_Y * pl->axis[bN].scale + pl->axis[bN].offset;
+	}
+
+	X = (double) (pl->viewport.max_x - pl->viewport.min_x);
+	Y = (double) (pl->viewport.min_y - pl->viewport.max_y);
+
+	scale_X *= X;
+	offset_X = offset_X * X + pl->viewport.min_x;
+	scale_Y *= Y;
+	offset_Y = offset_Y * Y + pl->viewport.max_y;
+
+	if (		pl->figure[fN].persist == FIGURE_PERSIST_TRIGGER
+			&& (tN < 0 || tN >= pl->data[dN].column_N + PLOT_SUBTRACT)) {
+
+		pl->draw[fN].sketch = SKETCH_FINISHED;
+		return ;
+	}
+
+	map[0] = scale_X;
+	map[1] = offset_X;
+	map[2] = scale_Y;
+	map[3] = offset_Y;
+
+	if (plotPersistSetUp(pl, fN, map) < 0) {
+
+		pl->draw[fN].sketch = SKETCH_FINISHED;
+		return ;
+	}
+
+	/* Each next segment gets larger weight than previous one. This is the
+	 * same as decay of all previous segments but costs nothing.
+	 * */
+	grow = (pl->figure[fN].persist_decay > 0.) ? 1. / pl->figure[fN].persist_decay : 1.;
+
+	rN = pl->draw[fN].rN;
+	id_N = pl->draw[fN].id_N;
+	line = pl->draw[fN].line;
+
+	top_N = id_N + (1UL << pl->data[dN].chunk_SHIFT);
+
+	last_im_X = pl->draw[fN].last_X;
+	last_im_Y = pl->draw[fN].last_Y;
+
+	do {
+		row = plotDataGet(pl, dN, &rN);
+
+		if (row == NULL) {
+
+			pl->draw[fN].sketch = SKETCH_FINISHED;
+			pl->draw[fN].persist_id_N = id_N;
+			break;
+		}
+
+		X = (xN < 0) ? id_N : row[xN];
+		Y = (yN < 0) ? id_N : row[yN];
+
+		if (pl->figure[fN].persist == FIGURE_PERSIST_PERIOD) {
+
+			seg = floor(X / pl->figure[fN].persist_period);
+
+			if (seg != pl->draw[fN].persist_origin) {
+
+				if (		seg > pl->draw[fN].persist_origin
+						&& seg < pl->draw[fN].persist_origin + 64.) {
+
+					pl->draw[fN].persist_weight *= pow(grow,
+							seg - pl->draw[fN].persist_origin);
+				}
+				else {
+					pl->draw[fN].persist_weight *= grow;
+				}
+
+				pl->draw[fN].persist_origin = seg;
+				line = 0;
+			}
+
+			X -= seg * pl->figure[fN].persist_period;
+		}
+		else {
+			T = row[tN];
+
+			if (T > 0. && pl->draw[fN].persist_trigger <= 0.) {
+
+				pl->draw[fN].persist_origin = X;
+				pl->draw[fN].persist_weight *= grow;
+				line = 0;
+			}
+
+			pl->draw[fN].persist_trigger = T;
+
+			X -= pl->draw[fN].persist_origin;
+
+			if (X > pl->draw[fN].persist_span)
+				pl->draw[fN].persist_span = X;
+		}
+
+		if (pl->draw[fN].persist_weight > 1E+6) {
+
+			plotPersistNormalize(pl, fN);
+		}
+
+		im_X = X * scale_X + offset_X;
+		im_Y = Y * scale_Y + offset_Y;
+
+		if (fp_isfinite(im_X) && fp_isfinite(im_Y)) {
+
+			if (		fdrawing == FIGURE_DRAWING_LINE
+					|| fdrawing == FIGURE_DRAWING_DASH) {
+
+				peak = (line != 0) ? drawDensityLine(pl->dw, &pl->viewport,
+						pl->draw[fN].density, last_im_X, last_im_Y,
+						im_X, im_Y, pl->draw[fN].persist_weight) : 0.f;
+
+				line = 1;
+			}
+			else {
+				peak = drawDensityTrial(pl->dw, &pl->viewport,
+						pl->draw[fN].density, im_X, im_Y, fwidth,
+						pl->draw[fN].persist_weight);
+			}
+
+			if (peak > pl->draw[fN].density_peak)
+				pl->draw[fN].density_peak = peak;
+
+			last_im_X = im_X;
+			last_im_Y = im_Y;
+		}
+		else {
+			line = 0;
+		}
+
+		id_N++;
+
+		if (id_N > top_N) {
+
+			pl->draw[fN].sketch = SKETCH_INTERRUPTED;
+			break;
+		}
+	}
+	while (1);
+
+	pl->draw[fN].rN = rN;
+	pl->draw[fN].id_N = id_N;
+	pl->draw[fN].line = line;
+	pl->draw[fN].last_X = last_im_X;
+	pl->draw[fN].last_Y = last_im_Y;
+}
+
+static void
+plotDrawDensity(plot_t *pl, SDL_Surface *surface)
+{
+	double		scale_X, offset_X, scale_Y, offset_Y, X, Y, map[4];
+	int		fN, aN, bN, ncolor;
 
-				if (yNR >= 0 && pl->rcache[yNR].chunk[kN].computed != 0) {
+	const float	*density;
+	const double	*dmap;
+	float		peak;
 
-					if (pl->rcache[yNR].chunk[kN].finite != 0) {
+	SDL_LockSurface(surface);
 
-						im_MIN = pl->rcache[yNR].chunk[kN].fmin * scale_Y + offset_Y;
-						im_MAX = pl->rcache[yNR].chunk[kN].fmax * scale_Y + offset_Y;
+	for (fN = 0; fN < PLOT_FIGURE_MAX; ++fN) {
 
-						job = (	   im_MIN < pl->viewport.min_y - 16
-							|| im_MAX > pl->viewport.max_y + 16) ? 0 : job;
-					}
-					else {
-						job = 0;
-					}
-				}
+		if (pl->figure[fN].busy == 0)
+			continue;
 
-				kN_cached = kN;
-			}
+		if (pl->figure[fN].persist != FIGURE_PERSIST_DISABLED) {
 
-			if (job != 0) {
+			density = pl->draw[fN].density;
+			peak = pl->draw[fN].density_peak;
+			dmap = pl->draw[fN].density_map;
+		}
+		else if (pl->figure[fN].drawing == FIGURE_DRAWING_DENSITY) {
 
-				row = plotDataGet(pl, dN, &rN);
+			density = pl->draw[fN].density_todraw;
+			peak = pl->draw[fN].density_todraw_peak;
+			dmap = pl->draw[fN].density_todraw_map;
+		}
+		else
+			continue;
 
-				if (row == NULL) {
+		if (density == NULL || peak <= 0.f)
+			continue;
 
-					pl->draw[fN].sketch = SKETCH_FINISHED;
-					break;
-				}
+		ncolor = (pl->figure[fN].hidden != 0) ? 9 : fN + 1;
 
-				X = (xN < 0) ? id_N : row[xN];
-				Y = (yN < 0) ? id_N : row[yN];
+		aN = pl->figure[fN].axis_X;
+		scale_X = pl->axis[aN].scale;
+		offset_X = pl->axis[aN].offset;
 
-				im_X = X * scale_X + offset_X;
-				im_Y = Y * scale_Y + offset_Y;
+		if (pl->axis[aN].slave != 0) {
 
-				if (fp_isfinite(im_X) && fp_isfinite(im_Y)) {
+			bN = pl->axis[aN].slave_N;
+			scale_X *= pl->axis[bN].scale;
+			offset_X = offset_X * pl->axis[bN].scale + pl->axis[bN].offset;
+		}
 
-					rc = drawDotTrial(pl->dw, &pl->viewport,
-							im_X, im_Y, fwidth,
-							ncolor, 1);
+		aN = pl->figure[fN].axis_Y;
+		scale_Y = pl->axis[aN].scale;
+		offset_Y = pl->axis[aN].offset;
 
-					if (rc != 0) {
+		if (pl->axis[aN].slave != 0) {
 
-						plotSketchDataAdd(pl, fN, X, Y);
-					}
-				}
+			bN = pl->axis[aN].slave_N;
+			scale_Y *= pl->axis[bN].scale;
+			offset_Y = offset_Y * pl->axis[bN].scale + pl->axis[bN].offset;
+		}
 
-				id_N++;
-			}
+		X = (double) (pl->viewport.max_x - pl->viewport.min_x);
+		Y = (double) (pl->viewport.min_y - pl->viewport.max_y);
 
-			if (job == 0) {
+		scale_X *= X;
+		offset_X = offset_X * X + pl->viewport.min_x;
+		scale_Y *= Y;
+		offset_Y = offset_Y * Y + pl->viewport.max_y;
 
-				plotDataChunkSkip(pl, dN, &rN, &id_N);
-			}
+		/* Map the current image back into the image that the hit counts
+		 * was accumulated with. So we do not have to wait for the next
+		 * pass to be finished to see zoomed density.
+		 * */
+		map[0] = dmap[0] / scale_X;
+		map[1] = dmap[1] - offset_X * map[0];
+		map[2] = dmap[2] / scale_Y;
+		map[3] = dmap[3] - offset_Y * map[2];
 
-			if (id_N > top_N) {
+		if (		fp_isfinite(map[0]) && fp_isfinite(map[1])
+				&& fp_isfinite(map[2]) && fp_isfinite(map[3])) {
 
-				pl->draw[fN].sketch = SKETCH_INTERRUPTED;
-				pl->draw[fN].rN = rN;
-				pl->draw[fN].id_N = id_N;
-				break;
-			}
+			drawDensityCanvas(pl->dw, surface, &pl->viewport,
+					density, peak, ncolor, map);
 		}
-		while (1);
 	}
+
+	SDL_UnlockSurface(surface);
 }
 
 static void
@@ -5548,6 +6405,14 @@ plotLegendDraw(plot_t *pl, SDL_Surface *surface)
 							2, ncolor, 1);
 				}
 			}
+			else if (pl->figure[fN].drawing == FIGURE_DRAWING_DENSITY) {
+
+				boxX = legX + pl->layout_font_height;
+
+				drawDotCanvas(pl->dw, surface, &pl->viewport,
+						boxX + .5, boxY + .5,
+						pl->layout_font_height / 2, ncolor, 0);
+			}
 
 			if (pl->mark_on != 0) {
 
@@ -5668,6 +6533,35 @@ plotDataBoxLayout(plot_t *pl)
 		pl->data_box_Y = pl->viewport.min_y + pl->layout_font_height;
 }
 
+static void
+plotDamage(plot_t *pl, int min_x, int min_y, int max_x, int max_y)
+{
+	clipBox_t	*cb;
+
+	if (min_x > max_x || min_y > max_y)
+		return ;
+
+	if (pl->damage_N < PLOT_DAMAGE_MAX) {
+
+		cb = &pl->damage[pl->damage_N++];
+
+		cb->min_x = min_x;
+		cb->min_y = min_y;
+		cb->max_x = max_x;
+		cb->max_y = max_y;
+	}
+	else {
+		/* Grow the last region to take the rest.
+		 * */
+		cb = &pl->damage[PLOT_DAMAGE_MAX - 1];
+
+		cb->min_x = (min_x < cb->min_x) ? min_x : cb->min_x;
+		cb->min_y = (min_y < cb->min_y) ? min_y : cb->min_y;
+		cb->max_x = (max_x > cb->max_x) ? max_x : cb->max_x;
+		cb->max_y = (max_y > cb->max_y) ? max_y : cb->max_y;
+	}
+}
+
 static void
 plotDataBoxDraw(plot_t *pl, SDL_Surface *surface)
 {
@@ -5694,6 +6588,8 @@ plotDataBoxDraw(plot_t *pl, SDL_Surface *surface)
 
 	SDL_UnlockSurface(surface);
 
+	plotDamage(pl, legX, legY, legX + size_X, legY + size_Y);
+
 	if (pl->data_box_on == DATA_BOX_SLICE) {
 
 		for (N = 0; N < PLOT_FIGURE_MAX; ++N) {
@@ -5806,6 +6702,9 @@ plotDrawFigureTrialAll(plot_t *pl)
 {
 	int		FIGS[PLOT_FIGURE_MAX];
 	int		N, fN, fQ, lN, dN, tTOP;
+	Uint64		tSTART;
+
+	pl->draw_spent = 0;
 
 	lN = 0;
 
@@ -5829,11 +6728,20 @@ plotDrawFigureTrialAll(plot_t *pl)
 			dN = pl->figure[fN].data_N;
 
 			pl->draw[fN].sketch = SKETCH_STARTED;
+
+			if (pl->figure[fN].persist != FIGURE_PERSIST_DISABLED) {
+
+				plotPersistResume(pl, fN);
+				continue;
+			}
+
 			pl->draw[fN].rN = pl->data[dN].head_N;
 			pl->draw[fN].id_N = pl->data[dN].id_N;
 
 			pl->draw[fN].skipped = 0;
 			pl->draw[fN].line = 0;
+
+			pl->draw[fN].density_peak = -1.f;
 		}
 
 		pl->draw_in_progress = 1;
@@ -5841,7 +6749,8 @@ plotDrawFigureTrialAll(plot_t *pl)
 
 	if (pl->draw_in_progress != 0) {
 
-		tTOP = SDL_GetTicks() + 20;
+		tSTART = SDL_GetPerformanceCounter();
+		tTOP = SDL_GetTicks() + pl->draw_budget;
 
 		drawClearTrial(pl->dw);
 
@@ -5867,7 +6776,13 @@ plotDrawFigureTrialAll(plot_t *pl)
 
 			if (fN >= 0) {
 
-				plotDrawFigureTrial(pl, fN);
+				if (pl->figure[fN].persist != FIGURE_PERSIST_DISABLED) {
+
+					plotDrawFigurePersist(pl, fN);
+				}
+				else {
+					plotDrawFigureTrial(pl, fN);
+				}
 			}
 			else {
 				plotSketchGarbage(pl);
@@ -5876,7 +6791,12 @@ plotDrawFigureTrialAll(plot_t *pl)
 				break;
 			}
 		}
-		while (SDL_GetTicks() < tTOP);
+		while (pl->draw_budget == 0 || SDL_GetTicks() < tTOP);
+
+		/* Time actually spent in microseconds.
+		 * */
+		pl->draw_spent = (int) ((SDL_GetPerformanceCounter() - tSTART)
+				* 1000000U / SDL_GetPerformanceFrequency());
 	}
 }
 
@@ -5894,6 +6814,331 @@ plotDrawAxisAll(plot_t *pl, SDL_Surface *surface)
 	}
 }
 
+static Uint64
+plotLayerHash(Uint64 hash, const void *data, int len)
+{
+	const Uint8	*bytes = (const Uint8 *) data;
+	int		N;
+
+	for (N = 0; N < len; ++N) {
+
+		hash = (hash ^ bytes[N]) * 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+static Uint64
+plotLayerState(plot_t *pl, SDL_Surface *surface)
+{
+	Uint64		hash = 14695981039346656037ULL;
+	int		aN, fN;
+
+	/* Everything that axes drawing depends on.
+	 * */
+	hash = plotLayerHash(hash, &surface->w, sizeof(int));
+	hash = plotLayerHash(hash, &surface->h, sizeof(int));
+	hash = plotLayerHash(hash, &pl->viewport, sizeof(clipBox_t));
+	hash = plotLayerHash(hash, &pl->screen, sizeof(clipBox_t));
+	hash = plotLayerHash(hash, pl->sch, sizeof(scheme_t));
+	hash = plotLayerHash(hash, &pl->font, sizeof(TTF_Font *));
+	hash = plotLayerHash(hash, &pl->dw->solidfont, sizeof(int));
+
+	for (aN = 0; aN < PLOT_AXES_MAX; ++aN) {
+
+		hash = plotLayerHash(hash, &pl->axis[aN].busy, sizeof(int));
+
+		if (pl->axis[aN].busy == AXIS_FREE)
+			continue;
+
+		hash = plotLayerHash(hash, &pl->axis[aN].slave, sizeof(int));
+		hash = plotLayerHash(hash, &pl->axis[aN].slave_N, sizeof(int));
+		hash = plotLayerHash(hash, &pl->axis[aN].scale, sizeof(double));
+		hash = plotLayerHash(hash, &pl->axis[aN].offset, sizeof(double));
+		hash = plotLayerHash(hash, pl->axis[aN].label, strlen(pl->axis[aN].label));
+		hash = plotLayerHash(hash, &pl->axis[aN].compact, sizeof(int));
+		hash = plotLayerHash(hash, &pl->axis[aN].expen, sizeof(int));
+		hash = plotLayerHash(hash, &pl->axis[aN]._pos, sizeof(int));
+	}
+
+	for (fN = 0; fN < PLOT_FIGURE_MAX; ++fN) {
+
+		hash = plotLayerHash(hash, &pl->figure[fN].busy, sizeof(int));
+		hash = plotLayerHash(hash, &pl->figure[fN].hidden, sizeof(int));
+		hash = plotLayerHash(hash, &pl->figure[fN].axis_X, sizeof(int));
+		hash = plotLayerHash(hash, &pl->figure[fN].axis_Y, sizeof(int));
+	}
+
+	hash = plotLayerHash(hash, &pl->layout_font_height, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_font_long, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_border, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_axis_box, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_label_box, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_tick_tooth, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_grid_dash, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_grid_space, sizeof(int));
+
+	hash = plotLayerHash(hash, &pl->on_X, sizeof(int));
+	hash = plotLayerHash(hash, &pl->on_Y, sizeof(int));
+	hash = plotLayerHash(hash, &pl->hover_figure, sizeof(int));
+	hash = plotLayerHash(hash, &pl->hover_axis, sizeof(int));
+	hash = plotLayerHash(hash, &pl->shift_on, sizeof(int));
+
+	return hash;
+}
+
+void plotDrawLayer(plot_t *pl, SDL_Surface *surface)
+{
+	Uint64		hash;
+
+	pl->damage_N = 0;
+
+	if (surface->userdata != NULL) {
+
+		/* Vector export needs all of the primitives.
+		 * */
+		SDL_LockSurface(surface);
+
+		drawClearSurface(pl->dw, surface, pl->sch->plot_background);
+
+		SDL_UnlockSurface(surface);
+
+		plotDrawAxisAll(pl, surface);
+		return ;
+	}
+
+	if (		pl->layer != NULL
+			&& (pl->layer->w != surface->w
+			|| pl->layer->h != surface->h)) {
+
+		SDL_FreeSurface(pl->layer);
+
+		pl->layer = NULL;
+	}
+
+	if (pl->layer == NULL) {
+
+		pl->layer = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h,
+				32, surface->format->format);
+
+		if (pl->layer == NULL) {
+
+			ERROR("Unable to allocate the static layer\n");
+			return ;
+		}
+
+		pl->layer_valid = 0;
+	}
+
+	hash = plotLayerState(pl, surface);
+
+	if (pl->layer_valid == 0 || pl->layer_hash != hash) {
+
+		SDL_LockSurface(pl->layer);
+
+		drawClearSurface(pl->dw, pl->layer, pl->sch->plot_background);
+
+		SDL_UnlockSurface(pl->layer);
+
+		plotDrawAxisAll(pl, pl->layer);
+
+		pl->layer_hash = hash;
+		pl->layer_valid = 1;
+
+		plotDamage(pl, 0, 0, surface->w - 1, surface->h - 1);
+	}
+
+	SDL_BlitSurface(pl->layer, NULL, surface, NULL);
+}
+
+static Uint64
+plotOverlayState(plot_t *pl, SDL_Surface *surface)
+{
+	Uint64		hash;
+	int		fN;
+
+	/* Legend and title are drawn by the same rules as axes and
+	 * take a few more inputs.
+	 * */
+	hash = plotLayerState(pl, surface);
+
+	hash = plotLayerHash(hash, &pl->legend_X, sizeof(int));
+	hash = plotLayerHash(hash, &pl->legend_Y, sizeof(int));
+	hash = plotLayerHash(hash, &pl->legend_size_X, sizeof(int));
+	hash = plotLayerHash(hash, &pl->legend_N, sizeof(int));
+	hash = plotLayerHash(hash, &pl->hover_legend, sizeof(int));
+	hash = plotLayerHash(hash, &pl->transparency_mode, sizeof(int));
+	hash = plotLayerHash(hash, &pl->mark_on, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_mark, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_drawing_dash, sizeof(int));
+	hash = plotLayerHash(hash, &pl->layout_drawing_space, sizeof(int));
+	hash = plotLayerHash(hash, &pl->dw->antialiasing, sizeof(int));
+
+	for (fN = 0; fN < PLOT_FIGURE_MAX; ++fN) {
+
+		if (pl->figure[fN].busy == 0)
+			continue;
+
+		hash = plotLayerHash(hash, pl->figure[fN].label, strlen(pl->figure[fN].label));
+		hash = plotLayerHash(hash, &pl->figure[fN].drawing, sizeof(int));
+		hash = plotLayerHash(hash, &pl->figure[fN].width, sizeof(int));
+	}
+
+	hash = plotLayerHash(hash, pl->title, strlen(pl->title));
+
+	return hash;
+}
+
+static void
+plotTitleDraw(plot_t *pl, SDL_Surface *surface)
+{
+	drawText(pl->dw, surface, pl->font, (pl->screen.min_x + pl->screen.max_x) / 2,
+			pl->screen.min_y - pl->layout_font_height / 2, pl->title,
+			TEXT_CENTERED, pl->sch->plot_text);
+}
+
+static void
+plotOverlayBox(clipBox_t *cb, SDL_Surface *surface, int xs, int ys, int xe, int ye)
+{
+	cb->min_x = (xs < 0) ? 0 : xs;
+	cb->min_y = (ys < 0) ? 0 : ys;
+	cb->max_x = (xe > surface->w - 1) ? surface->w - 1 : xe;
+	cb->max_y = (ye > surface->h - 1) ? surface->h - 1 : ye;
+}
+
+static void
+plotOverlayRender(plot_t *pl, SDL_Surface *surface)
+{
+	const colType_t		col[2] = { 0x000000U, 0xFFFFFFU };
+	int			N, fN, pad, txlen, txh;
+
+	for (N = 0; N < 2; ++N) {
+
+		SDL_LockSurface(pl->overlay[N]);
+
+		drawClearSurface(pl->dw, pl->overlay[N], col[N]);
+
+		SDL_UnlockSurface(pl->overlay[N]);
+
+		drawClearCanvas(pl->dw);
+
+		plotLegendDraw(pl, pl->overlay[N]);
+
+		drawFlushCanvas(pl->dw, pl->overlay[N], &pl->viewport);
+		drawClearCanvas(pl->dw);
+
+		if (pl->title[0] != 0) {
+
+			plotTitleDraw(pl, pl->overlay[N]);
+		}
+	}
+
+	/* Legend marks could stick out of the box.
+	 * */
+	pad = pl->layout_font_height + pl->layout_mark;
+
+	for (fN = 0; fN < PLOT_FIGURE_MAX; ++fN) {
+
+		if (pl->figure[fN].busy != 0 && pad < pl->figure[fN].width + pl->layout_mark)
+			pad = pl->figure[fN].width + pl->layout_mark;
+	}
+
+	plotOverlayBox(&pl->overlay_box[0], surface, pl->legend_X - pad, pl->legend_Y - pad,
+			pl->legend_X + pl->layout_font_height * 2 + pl->legend_size_X + pad,
+			pl->legend_Y + pl->layout_font_height * pl->legend_N + pad);
+
+	txlen = 0;
+	txh = 0;
+
+	if (pl->title[0] != 0) {
+
+		TTF_SizeUTF8(pl->font, pl->title, &txlen, &txh);
+	}
+
+	pad = pl->layout_font_height / 2 + 1;
+
+	plotOverlayBox(&pl->overlay_box[1], surface,
+			(pl->screen.min_x + pl->screen.max_x - txlen) / 2 - pad,
+			pl->screen.min_y - (pl->layout_font_height + txh) / 2 - pad,
+			(pl->screen.min_x + pl->screen.max_x + txlen) / 2 + pad,
+			pl->screen.min_y - (pl->layout_font_height - txh) / 2 + pad);
+}
+
+static void
+plotDrawOverlay(plot_t *pl, SDL_Surface *surface, int N)
+{
+	Uint64		hash;
+
+	if (surface->userdata != NULL) {
+
+		/* Vector export needs all of the primitives.
+		 * */
+		if (N == 0) {
+
+			plotLegendDraw(pl, surface);
+		}
+		else if (pl->title[0] != 0) {
+
+			plotTitleDraw(pl, surface);
+		}
+
+		return ;
+	}
+
+	if (		pl->overlay[0] != NULL
+			&& (pl->overlay[0]->w != surface->w
+			|| pl->overlay[0]->h != surface->h)) {
+
+		plotOverlayFree(pl);
+	}
+
+	if (pl->overlay[0] == NULL) {
+
+		pl->overlay[0] = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h,
+				32, surface->format->format);
+		pl->overlay[1] = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h,
+				32, surface->format->format);
+
+		if (pl->overlay[0] == NULL || pl->overlay[1] == NULL) {
+
+			ERROR("Unable to allocate the overlay layer\n");
+			plotOverlayFree(pl);
+			return ;
+		}
+
+		pl->overlay_valid = 0;
+	}
+
+	/* Data is flushed at this moment so canvas is free to render the
+	 * overlay if it was changed.
+	 * */
+	if (N == 0) {
+
+		hash = plotOverlayState(pl, surface);
+
+		if (pl->overlay_valid == 0 || pl->overlay_hash != hash) {
+
+			plotOverlayRender(pl, surface);
+
+			pl->overlay_hash = hash;
+			pl->overlay_valid = 1;
+		}
+	}
+
+	if (pl->overlay_valid != 0) {
+
+		SDL_LockSurface(surface);
+
+		drawOverlay(surface, pl->overlay[0], pl->overlay[1],
+				&pl->overlay_box[N]);
+
+		SDL_UnlockSurface(surface);
+
+		plotDamage(pl, pl->overlay_box[N].min_x, pl->overlay_box[N].min_y,
+				pl->overlay_box[N].max_x, pl->overlay_box[N].max_y);
+	}
+}
+
 void plotDraw(plot_t *pl, SDL_Surface *surface)
 {
 	if (pl->slice_range_on != 0) {
@@ -5908,6 +7153,7 @@ void plotDraw(plot_t *pl, SDL_Surface *surface)
 
 	drawClearCanvas(pl->dw);
 
+	plotDrawDensity(pl, surface);
 	plotDrawSketch(pl, surface);
 
 	if (pl->mark_on != 0) {
@@ -5918,22 +7164,27 @@ void plotDraw(plot_t *pl, SDL_Surface *surface)
 	drawFlushCanvas(pl->dw, surface, &pl->viewport);
 	drawClearCanvas(pl->dw);
 
+	/* Data area is drawn again on each frame.
+	 * */
+	plotDamage(pl, pl->viewport.min_x, pl->viewport.min_y,
+			pl->viewport.max_x, pl->viewport.max_y);
+
 	drawDashReset(pl->dw);
 
-	plotDrawAxisAll(pl, surface);
+	plotDrawOverlay(pl, surface, 0);
 
 	if (pl->slice_on != 0) {
 
 		plotSliceDraw(pl, surface);
 	}
 
-	plotLegendDraw(pl, surface);
-
 	drawFlushCanvas(pl->dw, surface, &pl->viewport);
 
 	if (pl->data_box_on != DATA_BOX_FREE) {
 
 		plotDataBoxDraw(pl, surface);
 	}
+
+	plotDrawOverlay(pl, surface, 1);
 }
 
@@ -53,6 +53,7 @@
 #define PLOT_SKETCH_CHUNK_SIZE			32768
 #define PLOT_SKETCH_MAX				800
 #define PLOT_STRING_MAX				200
+#define PLOT_DAMAGE_MAX				8
 
 enum {
 	TTF_ID_NONE			= 0,
@@ -75,7 +76,14 @@ enum {
 enum {
 	FIGURE_DRAWING_LINE		= 0,
 	FIGURE_DRAWING_DASH,
-	FIGURE_DRAWING_DOT
+	FIGURE_DRAWING_DOT,
+	FIGURE_DRAWING_DENSITY
+};
+
+enum {
+	FIGURE_PERSIST_DISABLED		= 0,
+	FIGURE_PERSIST_PERIOD,
+	FIGURE_PERSIST_TRIGGER
 };
 
 enum {
@@ -273,6 +281,11 @@ typedef struct {
 		int		drawing;
 		int		width;
 
+		int		persist;
+		int		persist_column;
+		double		persist_period;
+		double		persist_decay;
+
 		int		data_N;
 		int		column_X;
 		int		column_Y;
@@ -309,6 +322,25 @@ typedef struct {
 
 	TTF_Font		*font;
 
+	SDL_Surface		*layer;
+	Uint64			layer_hash;
+	int			layer_valid;
+
+	/* Legend and title are drawn over black and white backgrounds so
+	 * they can be laid over the data with the proper coverage.
+	 * */
+	SDL_Surface		*overlay[2];
+	clipBox_t		overlay_box[2];
+	Uint64			overlay_hash;
+	int			overlay_valid;
+
+	char			title[PLOT_STRING_MAX];
+
+	/* Regions of the surface that were drawn over by the last frame.
+	 * */
+	clipBox_t		damage[PLOT_DAMAGE_MAX];
+	int			damage_N;
+
 	lse_t			lsq;
 
 	int			rcache_ID;
@@ -345,10 +377,28 @@ typedef struct {
 		double		last_Y;
 
 		int		list_self;
+
+		float		*density;
+		float		*density_todraw;
+		int		density_len;
+		float		density_peak;
+		float		density_todraw_peak;
+		double		density_map[4];
+		double		density_todraw_map[4];
+
+		int		persist_id_N;
+		int		persist_conf[7];
+		double		persist_args[2];
+		double		persist_origin;
+		double		persist_trigger;
+		double		persist_weight;
+		double		persist_span;
 	}
 	draw[PLOT_FIGURE_MAX];
 
 	int			draw_in_progress;
+	int			draw_budget;
+	int			draw_spent;
 
 	struct {
 
@@ -371,6 +421,7 @@ typedef struct {
 
 	int			layout_font_ttf;
 	int			layout_font_pt;
+	char			layout_font_file[PLOT_STRING_MAX];
 	int			layout_font_height;
 	int			layout_font_long;
 	int			layout_border;
@@ -404,6 +455,10 @@ typedef struct {
 	int			fprecision;
 	int			lz4_compress;
 
+	/* Dataset storage is owned by another plot.
+	 * */
+	int			data_shared;
+
 	int			shift_on;
 }
 plot_t;
@@ -414,6 +469,9 @@ int fp_isfinite(double x);
 plot_t *plotAlloc(draw_t *dw, scheme_t *sch);
 void plotClean(plot_t *pl);
 
+plot_t *plotClone(plot_t *pl, draw_t *dw);
+void plotCloneClean(plot_t *pl);
+
 void plotFontDefault(plot_t *pl, int ttfnum, int ptsize, int style);
 void plotFontOpen(plot_t *pl, const char *file, int ptsize, int style);
 
@@ -484,6 +542,7 @@ int plotLegendBoxGetByClick(plot_t *pl, int cur_X, int cur_Y);
 int plotDataBoxGetByClick(plot_t *pl, int cur_X, int cur_Y);
 
 void plotLayout(plot_t *pl);
+void plotDrawLayer(plot_t *pl, SDL_Surface *surface);
 void plotDraw(plot_t *pl, SDL_Surface *surface);
 
 #endif /* _H_PLOT_ */
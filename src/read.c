@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include <errno.h>
 
 #include <SDL2/SDL.h>
@@ -33,6 +34,41 @@
 #include "plot.h"
 #include "read.h"
 
+typedef struct {
+
+	read_t		*rd;
+	int		dN;
+
+	int		line_N;
+	int		stride;
+
+	/* Block workers take the rows out of order so they do not change
+	 * the column hints and rely on the probe instead.
+	 * */
+	int		detect;
+}
+text_parse_t;
+
+/* Index file keeps the offset of each step row that was delivered by the
+ * reader starting from origin. It is only valid for the same file size and
+ * modification time.
+ * */
+typedef struct {
+
+	char			magic[8];
+
+	unsigned long long	size;
+	unsigned long long	mtime;
+
+	long long		origin;
+
+	int			step;
+	int			row_N;
+	int			entry_N;
+	int			reserved;
+}
+index_head_t;
+
 int utf8_length(const char *s);
 const char *utf8_skip(const char *s, int n);
 const char *utf8_skip_b(const char *s, int n);
@@ -59,7 +95,7 @@ stoi(const markup_t *mk, int *x, char *s)
 
 	if (k == 0) return NULL;
 
-	if (*s == 0 || strchr(mk->space, *s) != NULL || strchr(mk->lend, *s) != NULL) {
+	if (mk->map[(unsigned char) *s] != 0) {
 
 		*x = i;
 	}
@@ -93,7 +129,7 @@ htoi(const markup_t *mk, int *x, char *s)
 
 	if (k == 0) return NULL;
 
-	if (*s == 0 || strchr(mk->space, *s) != NULL || strchr(mk->lend, *s) != NULL) {
+	if (mk->map[(unsigned char) *s] != 0) {
 
 		*x = h;
 	}
@@ -123,7 +159,7 @@ otoi(const markup_t *mk, int *x, char *s)
 
 	if (k == 0) return NULL;
 
-	if (*s == 0 || strchr(mk->space, *s) != NULL || strchr(mk->lend, *s) != NULL) {
+	if (mk->map[(unsigned char) *s] != 0) {
 
 		*x = h;
 	}
@@ -132,24 +168,81 @@ otoi(const markup_t *mk, int *x, char *s)
 	return s;
 }
 
+static const double	pow10_exact[] = {
+
+	1E+0, 1E+1, 1E+2, 1E+3, 1E+4, 1E+5, 1E+6, 1E+7, 1E+8, 1E+9, 1E+10,
+	1E+11, 1E+12, 1E+13, 1E+14, 1E+15, 1E+16, 1E+17, 1E+18, 1E+19, 1E+20,
+	1E+21, 1E+22
+};
+
+static double
+stod_slow(const markup_t *mk, const char *s, int v)
+{
+	char		tbuf[800];
+	int		n = 0;
+
+	/* Library conversion of digits without decimal point does not
+	 * depend on locale.
+	 * */
+	while (*s >= '0' && *s <= '9') {
+
+		if (n < 760) { tbuf[n++] = *s; } else { v++; }
+
+		s++;
+	}
+
+	if (*s == mk->delim) {
+
+		s++;
+
+		while (*s >= '0' && *s <= '9') {
+
+			if (n < 760) { tbuf[n++] = *s; v--; }
+
+			s++;
+		}
+	}
+
+	sprintf(tbuf + n, "e%i", v);
+
+	return strtod(tbuf, NULL);
+}
+
 static char *
 stod(const markup_t *mk, double *x, char *s)
 {
-	int		n, k, v, e;
-	double		f = 0.;
+	unsigned long long	w;
+	int			n, k, d, v, e, t;
+	char			*q;
+	double			f;
 
-	if (*s == '-') { n = - 1; s++; }
-	else if (*s == '+') { n = 1; s++; }
-	else { n = 1; }
+	if (*s == '-') { n = 1; s++; }
+	else if (*s == '+') { n = 0; s++; }
+	else { n = 0; }
+
+	q = s;
 
 	k = 0;
+	d = 0;
 	v = 0;
-	f = 0.;
+	t = 0;
+	w = 0;
 
+	/* We take up to 19 significant digits into the integer mantissa.
+	 * */
 	while (*s >= '0' && *s <= '9') {
 
-		f = 10. * f + (*s++ - '0') * n;
-		k++;
+		if (d < 19) {
+
+			w = 10U * w + (*s - '0');
+			d += (w != 0U) ? 1 : 0;
+		}
+		else {
+			t |= *s - '0';
+			v++;
+		}
+
+		s++; k++;
 	}
 
 	if (*s == mk->delim) {
@@ -158,39 +251,78 @@ stod(const markup_t *mk, double *x, char *s)
 
 		while (*s >= '0' && *s <= '9') {
 
-			f = 10. * f + (*s++ - '0') * n;
-			k++; v--;
+			if (d < 19) {
+
+				w = 10U * w + (*s - '0');
+				d += (w != 0U) ? 1 : 0;
+				v--;
+			}
+			else {
+				t |= *s - '0';
+			}
+
+			s++; k++;
 		}
 	}
 
 	if (k == 0) return NULL;
 
-	if (*s == 'n') { v += - 9; s++; }
-	else if (*s == 'u') { v += - 6; s++; }
-	else if (*s == 'm') { v += - 3; s++; }
-	else if (*s == 'K') { v += 3; s++; }
-	else if (*s == 'M') { v += 6; s++; }
-	else if (*s == 'G') { v += 9; s++; }
+	e = 0;
+
+	if (*s == 'n') { e = - 9; s++; }
+	else if (*s == 'u') { e = - 6; s++; }
+	else if (*s == 'm') { e = - 3; s++; }
+	else if (*s == 'K') { e = 3; s++; }
+	else if (*s == 'M') { e = 6; s++; }
+	else if (*s == 'G') { e = 9; s++; }
 	else if (*s == 'e' || *s == 'E') {
 
 		s = stoi(mk, &e, s + 1);
 
-		if (s != NULL) { v += e; }
-		else return NULL;
+		if (s == NULL) return NULL;
 	}
 
-	if (*s == 0 || strchr(mk->space, *s) != NULL || strchr(mk->lend, *s) != NULL) {
+	if (mk->map[(unsigned char) *s] == 0)
+		return NULL;
+
+	v += e;
 
-		while (v < 0) { f /= 10.; v++; }
-		while (v > 0) { f *= 10.; v--; }
+	if (w == 0U) {
 
-		*x = f;
+		f = 0.;
 	}
-	else return NULL;
+	else if (t == 0 && w <= (1ULL << 53) && v >= -22 && v <= 22) {
+
+		/* Both operands are exact so the result is correctly rounded.
+		 * */
+		f = (double) w;
+		f = (v < 0) ? f / pow10_exact[- v] : f * pow10_exact[v];
+	}
+	else {
+		f = stod_slow(mk, q, e);
+	}
+
+	*x = (n != 0) ? - f : f;
 
 	return s;
 }
 
+static void
+markupUpdate(markup_t *mk)
+{
+	const char	*s;
+
+	memset(mk->map, 0, sizeof(mk->map));
+
+	for (s = mk->space; *s != 0; ++s)
+		mk->map[(unsigned char) *s] |= MARKUP_SPACE;
+
+	for (s = mk->lend; *s != 0; ++s)
+		mk->map[(unsigned char) *s] |= MARKUP_LEND;
+
+	mk->map[0] |= MARKUP_LEND;
+}
+
 read_t *readAlloc(plot_t *pl)
 {
 	read_t		*rd;
@@ -208,6 +340,7 @@ read_t *readAlloc(plot_t *pl)
 	rd->thickness = 1;
 	rd->timecol = -1;
 	rd->shortfilename = 0;
+	rd->read_budget = 20;
 
 	rd->mk_config.delim = '.';
 	strcpy(rd->mk_config.space, " \t;");
@@ -217,6 +350,9 @@ read_t *readAlloc(plot_t *pl)
 	strcpy(rd->mk_text.space, rd->mk_config.space);
 	strcpy(rd->mk_text.lend, rd->mk_config.lend);
 
+	markupUpdate(&rd->mk_config);
+	markupUpdate(&rd->mk_text);
+
 #ifdef _WINDOWS
 	rd->legacy_label_enc = 0;
 #endif /* _WINDOWS */
@@ -226,6 +362,9 @@ read_t *readAlloc(plot_t *pl)
 	rd->timeout = 10000;
 	rd->length_N = 10000;
 
+	rd->stride = 1;
+	rd->window_cN = -1;
+
 	rd->bind_N = -1;
 	rd->page_N = -1;
 	rd->figure_N = -1;
@@ -233,11 +372,6 @@ read_t *readAlloc(plot_t *pl)
 	return rd;
 }
 
-void readClean(read_t *rd)
-{
-	free(rd);
-}
-
 #ifdef _WINDOWS
 void legacy_ACP_to_UTF8(char *ustr, const char *text, int n)
 {
@@ -443,6 +577,7 @@ void legacy_readConfigGRM(read_t *rd, const char *confile, const char *file)
 
 					rd->page[rd->page_N].fig[rd->figure_N].busy = 1;
 					rd->page[rd->page_N].fig[rd->figure_N].drawing = -1;
+					rd->page[rd->page_N].fig[rd->figure_N].persist = FIGURE_PERSIST_DISABLED;
 					rd->page[rd->page_N].fig[rd->figure_N].dN = 0;
 					rd->page[rd->page_N].fig[rd->figure_N].cX = cX;
 					rd->page[rd->page_N].fig[rd->figure_N].cY = cY;
@@ -496,17 +631,18 @@ FILE *unified_fopen(const char *file, const char *mode)
 }
 
 static int
-TEXT_GetRow(read_t *rd, int dN)
+TEXT_GetRow(read_t *rd, int dN, char *s, fval_t *row, const int *used, int detect)
 {
-	fval_t 		*row = rd->data[dN].row;
-	int		*hint = rd->data[dN].hint;
-	char 		*r, *s = rd->data[dN].buf;
-	int		hex, N = 0, m = 0;
+	const unsigned char	*map = rd->mk_text.map;
+
+	SDL_atomic_t	*hint = rd->data[dN].hint;
+	char 		*r;
+	int		hex, ht, N = 0, m = 0;
 	double		val;
 
 	while (*s != 0) {
 
-		if (strchr(rd->mk_text.space, *s) != NULL || strchr(rd->mk_text.lend, *s) != NULL) {
+		if (map[(unsigned char) *s] != 0) {
 
 			m = 0;
 		}
@@ -515,7 +651,14 @@ TEXT_GetRow(read_t *rd, int dN)
 
 				m = 1;
 
-				if (hint[N] == DATA_HINT_FLOAT) {
+				ht = (used != NULL && used[N] == 0) ? -1
+					: SDL_AtomicGet(&hint[N]);
+
+				if (ht < 0) {
+
+					*row++ = (fval_t) FP_NAN;
+				}
+				else if (ht == DATA_HINT_FLOAT) {
 
 					r = stod(&rd->mk_text, &val, s);
 
@@ -527,7 +670,7 @@ TEXT_GetRow(read_t *rd, int dN)
 						*row++ = (fval_t) FP_NAN;
 					}
 				}
-				else if (hint[N] == DATA_HINT_HEX) {
+				else if (ht == DATA_HINT_HEX) {
 
 					r = htoi(&rd->mk_text, &hex, s);
 
@@ -539,7 +682,7 @@ TEXT_GetRow(read_t *rd, int dN)
 						*row++ = (fval_t) FP_NAN;
 					}
 				}
-				else if (hint[N] == DATA_HINT_OCT) {
+				else if (ht == DATA_HINT_OCT) {
 
 					r = otoi(&rd->mk_text, &hex, s);
 
@@ -563,9 +706,14 @@ TEXT_GetRow(read_t *rd, int dN)
 
 						if (r != NULL) {
 
-							if (hint[N] == DATA_HINT_NONE) {
+							/* Column is taken as hex from
+							 * now on unless the user has
+							 * chosen the hint already.
+							 * */
+							if (detect != 0) {
 
-								hint[N] = DATA_HINT_HEX;
+								SDL_AtomicCAS(&hint[N], DATA_HINT_NONE,
+										DATA_HINT_HEX);
 							}
 
 							*row++ = (fval_t) hex;
@@ -608,7 +756,7 @@ TEXT_GetLabel(read_t *rd, int dN)
 
 	while (*s != 0) {
 
-		if (strchr(rd->mk_text.space, *s) != NULL || strchr(rd->mk_text.lend, *s) != NULL) {
+		if (rd->mk_text.map[(unsigned char) *s] != 0) {
 
 			if (m != 0) {
 
@@ -619,7 +767,7 @@ TEXT_GetLabel(read_t *rd, int dN)
 		else {
 			if (m == 0) {
 
-				rd->data[dN].hint[N] = DATA_HINT_NONE;
+				SDL_AtomicSet(&rd->data[dN].hint[N], DATA_HINT_NONE);
 				label = rd->data[dN].label[N++];
 
 				if (N >= READ_COLUMN_MAX)
@@ -645,7 +793,7 @@ TEXT_GetLabel(read_t *rd, int dN)
 }
 
 static char *
-follow_fgets(char *s, int len, FILE *fd, int timeout)
+follow_fgets(char *s, int len, FILE *fd, async_lz4_t *lz, async_sock_t *sk, int timeout)
 {
 	int		c, eol, nq, waiting;
 
@@ -654,7 +802,8 @@ follow_fgets(char *s, int len, FILE *fd, int timeout)
 	waiting = 0;
 
 	do {
-		c = fgetc(fd);
+		c = (lz != NULL) ? async_lz4_getc(lz)
+			: (sk != NULL) ? async_sock_getc(sk) : fgetc(fd);
 
 		if (c != EOF) {
 
@@ -664,7 +813,18 @@ follow_fgets(char *s, int len, FILE *fd, int timeout)
 			}
 			else if (eol == 1) {
 
-				ungetc(c, fd);
+				if (lz != NULL) {
+
+					async_lz4_ungetc(lz);
+				}
+				else if (sk != NULL) {
+
+					async_sock_ungetc(sk);
+				}
+				else {
+					ungetc(c, fd);
+				}
+
 				break;
 			}
 			else if (nq < len - 1) {
@@ -674,7 +834,23 @@ follow_fgets(char *s, int len, FILE *fd, int timeout)
 			}
 		}
 		else {
-			if (feof(fd) || ferror(fd)) {
+			if (lz != NULL) {
+
+				break;
+			}
+			else if (sk != NULL) {
+
+				/* Receive has already waited for data.
+				 * */
+				if (sk->closed == 0 && waiting < timeout) {
+
+					waiting += ASYNC_SOCK_WAIT;
+				}
+				else {
+					break;
+				}
+			}
+			else if (feof(fd) || ferror(fd)) {
 
 				if (waiting < timeout) {
 
@@ -704,7 +880,8 @@ follow_fgets(char *s, int len, FILE *fd, int timeout)
 }
 
 static int
-TEXT_GetCN(read_t *rd, int dN, FILE *fd, fval_t *rbuf)
+TEXT_GetCN(read_t *rd, int dN, FILE *fd, async_lz4_t *lz, async_sock_t *sk,
+		fval_t *rbuf)
 {
 	int		label_cN, fixed_N, total_N;
 	int		N, cN, timeout;
@@ -716,10 +893,10 @@ TEXT_GetCN(read_t *rd, int dN, FILE *fd, fval_t *rbuf)
 	fixed_N = 0;
 	total_N = 0;
 
-	timeout = (rd->data[dN].follow != 0) ? rd->timeout : 0;
+	timeout = (rd->data[dN].follow != 0 || sk != NULL) ? rd->timeout : 0;
 
 	do {
-		r = follow_fgets(rd->data[dN].buf, sizeof(rd->data[0].buf), fd, timeout);
+		r = follow_fgets(rd->data[dN].buf, sizeof(rd->data[0].buf), fd, lz, sk, timeout);
 
 		total_N++;
 
@@ -731,7 +908,7 @@ TEXT_GetCN(read_t *rd, int dN, FILE *fd, fval_t *rbuf)
 			label_cN = TEXT_GetLabel(rd, dN);
 		}
 		else {
-			cN = TEXT_GetRow(rd, dN);
+			cN = TEXT_GetRow(rd, dN, rd->data[dN].buf, rd->data[dN].row, NULL, 1);
 
 			if (cN != 0) {
 
@@ -766,213 +943,1699 @@ TEXT_GetCN(read_t *rd, int dN, FILE *fd, fval_t *rbuf)
 	return cN;
 }
 
-static ulen_t
-FILE_GetSize(const char *file)
+static void
+TEXT_ProbeHint(read_t *rd, int dN, FILE *fd)
 {
-	unsigned long long	sb;
+	long long	pos;
+	int		N;
 
-	if (fstatsize(file, &sb) != 0) {
+	/* Hints are settled from the leading rows before any reader is
+	 * started so all of the readers parse the same way.
+	 * */
+	pos = async_tell(fd);
 
-		sb = 0U;
+	for (N = 0; N < READ_TEXT_PROBE_MAX; ++N) {
+
+		if (follow_fgets(rd->data[dN].buf, sizeof(rd->data[0].buf),
+					fd, NULL, NULL, 0) == NULL)
+			break;
+
+		TEXT_GetRow(rd, dN, rd->data[dN].buf, rd->data[dN].row, NULL, 1);
 	}
 
-	return (ulen_t) sb;
+	clearerr(fd);
+	async_seek(fd, pos);
 }
 
-static void
-readClose(read_t *rd, int dN)
+static int
+readWindow(read_t *rd, int dN, const fval_t *row)
 {
-	async_close(rd->data[dN].afd);
+	fval_t		fval;
 
-	if (rd->data[dN].fd != stdin) {
+	if (rd->data[dN].window == 0)
+		return 0;
 
-		fclose(rd->data[dN].fd);
-	}
+	fval = row[rd->data[dN].window_cN];
 
-	rd->data[dN].fd = NULL;
-	rd->data[dN].afd = NULL;
+	if (fval > rd->data[dN].window_max)
+		return 1;
 
-	rd->files_N -= 1;
+	return (fval >= rd->data[dN].window_min) ? 0 : -1;
 }
 
-void readOpenUnified(read_t *rd, int dN, int cN, int lN, const char *file, int fmt)
+static int
+TEXT_Parse(text_parse_t *tp, char *line, fval_t *row)
 {
-	fval_t		rbuf[READ_COLUMN_MAX * 3];
-	FILE		*fd;
-	ulen_t		sF = 0U;
+	fval_t		tbuf[READ_COLUMN_MAX];
+	const int	*used = NULL;
+	int		cN, column_N, stride;
 
-	if (rd->data[dN].fd != NULL) {
+	/* This is called from a number of reader threads. But there is
+	 * only one reader with stride so we count lines here.
+	 * */
+	column_N = tp->rd->data[tp->dN].column_N;
+	stride = tp->stride;
 
-		readClose(rd, dN);
+	if (stride > 1) {
+
+		if (tp->line_N++ % stride != 0)
+			return 0;
 	}
 
-	if (file != NULL) {
+	if (tp->rd->data[tp->dN].projection != 0) {
 
-		fd = unified_fopen(file, "rb");
+		used = tp->rd->data[tp->dN].used;
 	}
-	else if (fmt == FORMAT_PLAIN_TEXT) {
 
-		fd = stdin;
-	}
+	cN = TEXT_GetRow(tp->rd, tp->dN, line, tbuf, used, tp->detect);
 
-	if (fd == NULL) {
+	if (cN == column_N) {
 
-		ERROR("fopen(\"%s\"): %s\n", file, strerror(errno));
-	}
-	else {
-		if (file != NULL) {
+		/* We stop reading when time is past the window as we
+		 * expect it does not decrease.
+		 * */
+		cN = readWindow(tp->rd, tp->dN, tbuf);
 
-			sF = FILE_GetSize(file);
-		}
+		if (cN != 0)
+			return (cN > 0) ? -1 : 0;
 
-		if (rd->data[dN].follow != 0 && sF != 0) {
+		memcpy(row, tbuf, column_N * sizeof(fval_t));
 
-			fseek(fd, 0UL, SEEK_END);
-		}
+		return 1;
+	}
 
-		rd->data[dN].length_N = lN;
+	return 0;
+}
 
-		if (fmt == FORMAT_PLAIN_TEXT) {
+static ulen_t
+FILE_GetSize(const char *file)
+{
+	unsigned long long	sb;
 
-			cN = TEXT_GetCN(rd, dN, fd, rbuf);
+	if (fstatsize(file, &sb) != 0) {
 
-			if (cN < 1) {
+		sb = 0U;
+	}
 
-				ERROR("No correct data in file \"%s\"\n",
-						(file != NULL) ? file : "STDIN");
-				fclose(fd);
-				return ;
-			}
+	return (ulen_t) sb;
+}
 
-			if (sF != 0 && lN < 1) {
+static void
+projectionMark(int *used, int column_N, int cN)
+{
+	if (cN >= 0 && cN < column_N) {
 
-				/* We do not use the file size to guess the
-				 * length since there is an incremental dataset
-				 * memory allocation.
-				 * */
-				lN = 1000;
-			}
-			else if (lN < 1) {
+		used[cN] = 1;
+	}
+}
 
-				lN = rd->length_N;
-			}
-		}
-		else if (fmt == FORMAT_BINARY_FLOAT) {
+static void
+projectionMask(read_t *rd, int dN, int *used)
+{
+	plot_t		*pl = rd->pl;
+	page_t		*pg;
+	int		N, pN, sN, column_N;
 
-			lN = (lN < 1) ? sF / (cN * sizeof(float)) : lN;
-			rd->data[dN].line_N = 1;
-		}
-		else if (fmt == FORMAT_BINARY_DOUBLE) {
+	column_N = rd->data[dN].column_N;
 
-			lN = (lN < 1) ? sF / (cN * sizeof(double)) : lN;
-			rd->data[dN].line_N = 1;
-		}
+	if (rd->data[dN].window != 0) {
 
-#ifdef _WINDOWS
-		else if (fmt == FORMAT_BINARY_LEGACY_V1) {
+		projectionMark(used, column_N, rd->data[dN].window_cN);
+	}
 
-			lN = (lN < 1) ? (sF - 6) / (cN * 6) : lN;
-			rd->data[dN].line_N = 1;
+	for (pN = 0; pN < READ_PAGE_MAX; ++pN) {
 
-			fseek(fd, 6UL, SEEK_SET);
-		}
-		else if (fmt == FORMAT_BINARY_LEGACY_V2) {
+		pg = rd->page + pN;
 
-			lN = (lN < 1) ? (sF - 4) / (cN * 4) : lN;
-			rd->data[dN].line_N = 1;
+		if (pg->busy == 0)
+			continue;
 
-			fseek(fd, 4UL, SEEK_SET);
-		}
-#endif /* _WINDOWS */
+		for (N = 0; N < PLOT_FIGURE_MAX; ++N) {
 
-		plotDataAlloc(rd->pl, dN, cN, lN + 1);
+			if (pg->fig[N].busy == 0 || pg->fig[N].dN != dN)
+				continue;
 
-		if (fmt == FORMAT_PLAIN_TEXT) {
+			projectionMark(used, column_N, pg->fig[N].cX);
+			projectionMark(used, column_N, pg->fig[N].cY);
+
+			if (pg->fig[N].ops[0].busy == SUBTRACT_BINARY_SUBTRACTION)
+				projectionMark(used, column_N, pg->fig[N].ops[0].column_2);
+
+			if (pg->fig[N].ops[1].busy == SUBTRACT_BINARY_SUBTRACTION)
+				projectionMark(used, column_N, pg->fig[N].ops[1].column_2);
 
-			plotDataInsert(rd->pl, dN, rbuf + READ_COLUMN_MAX * 0);
-			plotDataInsert(rd->pl, dN, rbuf + READ_COLUMN_MAX * 1);
-			plotDataInsert(rd->pl, dN, rbuf + READ_COLUMN_MAX * 2);
+			if (pg->fig[N].persist == FIGURE_PERSIST_TRIGGER)
+				projectionMark(used, column_N, pg->fig[N].persist_column);
 		}
+	}
 
-		rd->data[dN].format = fmt;
-		rd->data[dN].column_N = cN;
+	/* Figures could be changed from UI so take them too.
+	 * */
+	for (N = 0; N < PLOT_FIGURE_MAX; ++N) {
 
-		strcpy(rd->data[dN].file, (file != NULL) ? file : "STDIN");
+		if (pl->figure[N].busy == 0 || pl->figure[N].data_N != dN)
+			continue;
 
-		rd->data[dN].fd = fd;
-		rd->data[dN].afd = async_open(fd, rd->preload, rd->chunk, rd->timeout);
+		projectionMark(used, column_N, pl->figure[N].column_X);
+		projectionMark(used, column_N, pl->figure[N].column_Y);
 
-		rd->files_N += 1;
-		rd->bind_N = dN;
+		if (pl->figure[N].persist == FIGURE_PERSIST_TRIGGER)
+			projectionMark(used, column_N, pl->figure[N].persist_column);
 	}
-}
 
-void readOpenStub(read_t *rd, int dN, int cN, int lN, const char *file, int fmt)
-{
-	rd->data[dN].length_N = lN;
+	for (N = 0; N < PLOT_DATASET_MAX; ++N) {
 
-	lN = (lN < 1) ? 10 : lN;
+		for (sN = 0; sN < PLOT_SUBTRACT; ++sN) {
 
-	plotDataAlloc(rd->pl, dN, cN, lN + 1);
+			switch (pl->data[N].sub[sN].busy) {
 
-	rd->data[dN].format = fmt;
-	rd->data[dN].column_N = cN;
+				case SUBTRACT_TIME_UNWRAP:
 
-	strcpy(rd->data[dN].file, file);
+					if (N == dN) {
 
-	rd->bind_N = dN;
-}
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.time.column_1);
+					}
+					break;
 
-void readToggleHint(read_t *rd, int dN, int cN)
-{
-	if (rd->data[dN].format == FORMAT_NONE) {
+				case SUBTRACT_SCALE:
 
-		ERROR("Dataset number %i was not allocated\n", dN);
-		return ;
-	}
+					if (N == dN) {
 
-	if (cN < 0 || cN >= rd->data[dN].column_N) {
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.scale.column_1);
+					}
+					break;
 
-		return ;
-	}
+				case SUBTRACT_FILTER_DIFFERENCE:
+				case SUBTRACT_FILTER_CUMULATIVE:
+				case SUBTRACT_FILTER_BITMASK:
+				case SUBTRACT_FILTER_LOW_PASS:
 
-	if (rd->data[dN].hint[cN] == DATA_HINT_NONE) {
+					if (N == dN) {
 
-		rd->data[dN].hint[cN] = DATA_HINT_FLOAT;
-	}
-	else if (rd->data[dN].hint[cN] == DATA_HINT_FLOAT) {
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.filter.column_1);
+					}
+					break;
 
-		rd->data[dN].hint[cN] = DATA_HINT_HEX;
-	}
-	else if (rd->data[dN].hint[cN] == DATA_HINT_HEX) {
+				case SUBTRACT_BINARY_SUBTRACTION:
+				case SUBTRACT_BINARY_ADDITION:
+				case SUBTRACT_BINARY_MULTIPLICATION:
+				case SUBTRACT_BINARY_HYPOTENUSE:
 
-		rd->data[dN].hint[cN] = DATA_HINT_OCT;
-	}
-	else if (rd->data[dN].hint[cN] == DATA_HINT_OCT) {
+					if (N == dN) {
 
-		rd->data[dN].hint[cN] = DATA_HINT_NONE;
-	}
-}
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.binary.column_1);
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.binary.column_2);
+					}
+					break;
 
-static int
-TEXT_Read(read_t *rd, int dN)
-{
-	int		r, cN;
+				case SUBTRACT_RESAMPLE:
 
-	r = async_gets(rd->data[dN].afd, rd->data[dN].buf, sizeof(rd->data[0].buf));
+					if (N == dN) {
 
-	if (r == ASYNC_OK) {
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.resample.column_X);
+					}
 
-		cN = TEXT_GetRow(rd, dN);
+					if (pl->data[N].sub[sN].op.resample.in_data_N == dN) {
 
-		if (cN == rd->pl->data[dN].column_N) {
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.resample.column_in_X);
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.resample.column_in_Y);
+					}
+					break;
 
-			plotDataInsert(rd->pl, dN, rd->data[dN].row);
-		}
+				case SUBTRACT_POLYFIT:
 
-		return 1;
-	}
-	else if (r == ASYNC_END_OF_FILE) {
+					if (N == dN) {
+
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.polyfit.column_X);
+						projectionMark(used, column_N,
+								pl->data[N].sub[sN].op.polyfit.column_Y);
+					}
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+}
+
+static void
+indexClean(read_t *rd, int dN)
+{
+	if (rd->data[dN].index != NULL) {
+
+		free(rd->data[dN].index);
+	}
+
+	rd->data[dN].index = NULL;
+	rd->data[dN].index_N = 0;
+	rd->data[dN].index_max = 0;
+	rd->data[dN].index_row = 0;
+	rd->data[dN].index_build = 0;
+	rd->data[dN].index_first = 0;
+}
+
+static void
+indexAppend(read_t *rd, int dN, long long offset)
+{
+	long long	*index;
+
+	if (rd->data[dN].index_N >= rd->data[dN].index_max) {
+
+		rd->data[dN].index_max = (rd->data[dN].index_max < 1024)
+			? 1024 : rd->data[dN].index_max * 2;
+
+		index = realloc(rd->data[dN].index, rd->data[dN].index_max * sizeof(long long));
+
+		if (index == NULL) {
+
+			ERROR("No memory allocated for %i index\n", dN);
+
+			indexClean(rd, dN);
+			return ;
+		}
+
+		rd->data[dN].index = index;
+	}
+
+	rd->data[dN].index[rd->data[dN].index_N++] = offset;
+}
+
+static int
+indexLoad(read_t *rd, int dN, const char *file, long long origin)
+{
+	char		path[READ_FILE_PATH_MAX + 16];
+	index_head_t	head;
+	FILE		*fd;
+
+	unsigned long long	size, mtime;
+
+	indexClean(rd, dN);
+
+	rd->data[dN].index_origin = origin;
+
+	if (		fstatsize(file, &size) != 0
+			|| fstatmtime(file, &mtime) != 0)
+		return -1;
+
+	sprintf(path, "%s" READ_INDEX_SUFFIX, file);
+
+	fd = unified_fopen(path, "rb");
+
+	if (fd == NULL)
+		return -1;
+
+	if (		fread(&head, sizeof(head), 1, fd) != 1
+			|| memcmp(head.magic, "GPINDEX1", 8) != 0
+			|| head.size != size || head.mtime != mtime
+			|| head.origin != origin || head.step != rd->index_step
+			|| head.entry_N < 0 || head.row_N < 0) {
+
+		fclose(fd);
+		return -1;
+	}
+
+	rd->data[dN].index_max = (head.entry_N > 0) ? head.entry_N : 1;
+	rd->data[dN].index = malloc(rd->data[dN].index_max * sizeof(long long));
+
+	if (rd->data[dN].index == NULL) {
+
+		ERROR("No memory allocated for %i index\n", dN);
+
+		indexClean(rd, dN);
+		fclose(fd);
+		return -1;
+	}
+
+	if (fread(rd->data[dN].index, sizeof(long long), head.entry_N, fd) != head.entry_N) {
+
+		indexClean(rd, dN);
+		fclose(fd);
+		return -1;
+	}
+
+	fclose(fd);
+
+	rd->data[dN].index_N = head.entry_N;
+	rd->data[dN].index_row = head.row_N;
+
+	return 0;
+}
+
+static void
+indexSave(read_t *rd, int dN)
+{
+	char		path[READ_FILE_PATH_MAX + 16];
+	index_head_t	head;
+	FILE		*fd;
+
+	rd->data[dN].index_build = 0;
+
+	memset(&head, 0, sizeof(head));
+	memcpy(head.magic, "GPINDEX1", 8);
+
+	if (		fstatsize(rd->data[dN].file, &head.size) != 0
+			|| fstatmtime(rd->data[dN].file, &head.mtime) != 0)
+		return ;
+
+	head.origin = rd->data[dN].index_origin;
+	head.step = rd->index_step;
+	head.row_N = rd->data[dN].index_row;
+	head.entry_N = rd->data[dN].index_N;
+
+	sprintf(path, "%s" READ_INDEX_SUFFIX, rd->data[dN].file);
+
+	fd = unified_fopen(path, "wb");
+
+	if (fd == NULL) {
+
+		ERROR("fopen(\"%s\"): %s\n", path, strerror(errno));
+		return ;
+	}
+
+	if (		fwrite(&head, sizeof(head), 1, fd) != 1
+			|| fwrite(rd->data[dN].index, sizeof(long long),
+				head.entry_N, fd) != head.entry_N) {
+
+		ERROR("Unable to write index \"%s\"\n", path);
+	}
+
+	fclose(fd);
+}
+
+static fval_t
+indexTime(read_t *rd, int dN, FILE *fd, long long offset)
+{
+	async_seek(fd, offset);
+
+	if (follow_fgets(rd->data[dN].buf, sizeof(rd->data[0].buf), fd, NULL, NULL, 0) == NULL)
+		return (fval_t) FP_NAN;
+
+	if (		TEXT_GetRow(rd, dN, rd->data[dN].buf, rd->data[dN].row, NULL, 0)
+			!= rd->data[dN].column_N)
+		return (fval_t) FP_NAN;
+
+	return rd->data[dN].row[rd->data[dN].window_cN];
+}
+
+static void
+indexWindow(read_t *rd, int dN, FILE *fd)
+{
+	int		lo, hi, mid;
+
+	/* Find the first entry that is not before the window. The rows
+	 * between the previous entry and this one could be within.
+	 * */
+	lo = 0;
+	hi = rd->data[dN].index_N;
+
+	while (lo < hi) {
+
+		mid = lo + (hi - lo) / 2;
+
+		if (indexTime(rd, dN, fd, rd->data[dN].index[mid]) < rd->data[dN].window_min) {
+
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	async_seek(fd, (lo > 0) ? rd->data[dN].index[lo - 1]
+			: rd->data[dN].index_origin);
+}
+
+static void
+indexTail(read_t *rd, int dN, FILE *fd, int stride)
+{
+	long long	rN;
+	int		kN;
+
+	/* Dataset keeps only the last rows so we skip the entries that
+	 * would be overwritten anyway.
+	 * */
+	rN = (long long) rd->data[dN].length_N * stride;
+
+	if (rd->data[dN].index_row > rN) {
+
+		kN = (int) ((rd->data[dN].index_row - rN) / rd->index_step);
+		kN = (kN < rd->data[dN].index_N) ? kN : rd->data[dN].index_N - 1;
+
+		rd->data[dN].index_first = kN;
+
+		async_seek(fd, rd->data[dN].index[kN]);
+	}
+}
+
+static const int	field_size[] = { 1, 1, 2, 2, 4, 4, 8, 8, 4, 8 };
+
+static double
+fieldValue(const field_t *fi, const char *p)
+{
+	Uint16		u16;
+	Uint32		u32;
+	Uint64		u64;
+	float		f32;
+	double		fval;
+
+	switch (fi->type) {
+
+		case FIELD_U8:
+			fval = (double) * (const Uint8 *) p;
+			break;
+
+		case FIELD_I8:
+			fval = (double) * (const Sint8 *) p;
+			break;
+
+		case FIELD_U16:
+		case FIELD_I16:
+			memcpy(&u16, p, sizeof(u16));
+			u16 = (fi->swap != 0) ? SDL_Swap16(u16) : u16;
+			fval = (fi->type == FIELD_U16) ? (double) u16 : (double) (Sint16) u16;
+			break;
+
+		case FIELD_U32:
+		case FIELD_I32:
+			memcpy(&u32, p, sizeof(u32));
+			u32 = (fi->swap != 0) ? SDL_Swap32(u32) : u32;
+			fval = (fi->type == FIELD_U32) ? (double) u32 : (double) (Sint32) u32;
+			break;
+
+		case FIELD_F32:
+			memcpy(&u32, p, sizeof(u32));
+			u32 = (fi->swap != 0) ? SDL_Swap32(u32) : u32;
+			memcpy(&f32, &u32, sizeof(f32));
+			fval = (double) f32;
+			break;
+
+		case FIELD_U64:
+		case FIELD_I64:
+			memcpy(&u64, p, sizeof(u64));
+			u64 = (fi->swap != 0) ? SDL_Swap64(u64) : u64;
+			fval = (fi->type == FIELD_U64) ? (double) u64 : (double) (Sint64) u64;
+			break;
+
+		default:
+			memcpy(&u64, p, sizeof(u64));
+			u64 = (fi->swap != 0) ? SDL_Swap64(u64) : u64;
+			memcpy(&fval, &u64, sizeof(fval));
+			break;
+	}
+
+	return (fi->scaled != 0) ? fval * fi->scale + fi->bias : fval;
+}
+
+static int
+structParse(read_t *rd, int dN, const char *desc, char *msg)
+{
+	const char	*type_name[] = { "u8", "i8", "u16", "i16", "u32",
+					 "i32", "u64", "i64", "f32", "f64" };
+
+	field_t		fi, field[READ_COLUMN_MAX];
+	char		tbuf[READ_TOKEN_MAX], *s, *e;
+	const char	*name;
+	int		N, cN, count, pad, offset, big;
+
+	cN = 0;
+	offset = 0;
+
+	big = (SDL_BYTEORDER == SDL_BIG_ENDIAN) ? 1 : 0;
+
+	while (*desc != 0) {
+
+		while (*desc == ' ' || *desc == '\t') { desc++; }
+
+		if (*desc == 0)
+			break;
+
+		for (N = 0; *desc != 0 && *desc != ' ' && *desc != '\t'; ++desc) {
+
+			if (N < READ_TOKEN_MAX - 1) { tbuf[N++] = *desc; }
+		}
+
+		tbuf[N] = 0;
+		s = tbuf;
+
+		/* Byte order is kept for the following fields.
+		 * */
+		if (*s == '<') { big = 0; s++; }
+		else if (*s == '>') { big = 1; s++; }
+
+		memset(&fi, 0, sizeof(fi));
+
+		fi.swap = (big != ((SDL_BYTEORDER == SDL_BIG_ENDIAN) ? 1 : 0)) ? 1 : 0;
+		fi.scale = 1.;
+
+		pad = (*s == 'x') ? 1 : 0;
+
+		if (pad != 0) {
+
+			s++;
+		}
+		else {
+			for (N = 0; N < 10; ++N) {
+
+				name = type_name[N];
+
+				if (		strncmp(s, name, strlen(name)) == 0
+						&& strchr("*:", s[strlen(name)]) != NULL) {
+
+					break;
+				}
+			}
+
+			if (N >= 10) {
+
+				sprintf(msg, "invalid field type \"%.40s\"", tbuf);
+				return -1;
+			}
+
+			fi.type = N;
+			s += strlen(type_name[N]);
+		}
+
+		count = 1;
+
+		if (*s == '*') {
+
+			count = (int) strtol(s + 1, &e, 10);
+
+			if (		e == s + 1 || count < 1
+					|| count > (int) sizeof(rd->data[0].buf)) {
+
+				sprintf(msg, "invalid field count \"%.40s\"", tbuf);
+				return -1;
+			}
+
+			s = e;
+		}
+
+		if (*s == ':' && pad == 0) {
+
+			/* Colon does not end the number in config markup so
+			 * we cut the scale off before conversion.
+			 * */
+			e = strchr(s + 1, ':');
+
+			if (e != NULL) { *e = 0; }
+
+			s = stod(&rd->mk_config, &fi.scale, s + 1);
+
+			if (e != NULL) {
+
+				*e = ':';
+
+				if (s != NULL) {
+
+					s = stod(&rd->mk_config, &fi.bias, e + 1);
+				}
+			}
+
+			if (s == NULL) {
+
+				sprintf(msg, "invalid field scale \"%.40s\"", tbuf);
+				return -1;
+			}
+
+			fi.scaled = 1;
+		}
+
+		if (*s != 0) {
+
+			sprintf(msg, "invalid field \"%.40s\"", tbuf);
+			return -1;
+		}
+
+		if (pad != 0) {
+
+			offset += count;
+			continue;
+		}
+
+		if (cN + count > READ_COLUMN_MAX) {
+
+			sprintf(msg, "too many fields in struct");
+			return -1;
+		}
+
+		for (N = 0; N < count; ++N) {
+
+			fi.offset = offset;
+			offset += field_size[fi.type];
+
+			field[cN++] = fi;
+		}
+	}
+
+	if (cN < 1) {
+
+		sprintf(msg, "no fields in struct");
+		return -1;
+	}
+
+	if (offset > (int) sizeof(rd->data[0].buf)) {
+
+		sprintf(msg, "struct record of %i bytes is too long", offset);
+		return -1;
+	}
+
+	/* Dataset is changed only if the whole struct is correct.
+	 * */
+	memcpy(rd->data[dN].field, field, cN * sizeof(field_t));
+
+	rd->data[dN].record = offset;
+
+	return cN;
+}
+
+static double
+binaryTime(FILE *fd, long long offset, const field_t *fi)
+{
+	char		vbuf[8];
+
+	async_seek(fd, offset + fi->offset);
+
+	if (fread(vbuf, field_size[fi->type], 1, fd) == 1) {
+
+		return fieldValue(fi, vbuf);
+	}
+
+	return FP_NAN;
+}
+
+static long long
+binaryBound(FILE *fd, long long base, int record, const field_t *fi,
+		long long rN, double bound, int upper)
+{
+	long long	lo, hi, mid;
+	double		fval;
+
+	lo = 0;
+	hi = rN;
+
+	while (lo < hi) {
+
+		mid = lo + (hi - lo) / 2;
+		fval = binaryTime(fd, base + mid * record, fi);
+
+		if ((upper != 0) ? (fval <= bound) : (fval < bound)) {
+
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static void
+npyClose(read_t *rd, int dN)
+{
+	if (rd->data[dN].map != NULL) {
+
+		if (rd->data[dN].map_alloc != 0) {
+
+			free(rd->data[dN].map);
+		}
+		else {
+			fmunmap(rd->data[dN].map, rd->data[dN].map_size);
+		}
+
+		rd->data[dN].map = NULL;
+	}
+}
+
+static int
+npyCheck(FILE *fd)
+{
+	char		magic[6];
+	int		r;
+
+	r = (fread(magic, sizeof(magic), 1, fd) == 1
+			&& memcmp(magic, "\x93NUMPY", sizeof(magic)) == 0) ? 1 : 0;
+
+	fseek(fd, 0UL, SEEK_SET);
+
+	return r;
+}
+
+static const char *
+npyKey(const char *hbuf, const char *key)
+{
+	const char	*s;
+
+	s = strstr(hbuf, key);
+
+	if (s != NULL) {
+
+		s = strchr(s + strlen(key), ':');
+
+		if (s != NULL) {
+
+			s++;
+
+			while (*s == ' ') { s++; }
+		}
+	}
+
+	return s;
+}
+
+static int
+npyOpen(read_t *rd, int dN, FILE *fd, const char *file)
+{
+	unsigned char	pre[12];
+	char		hbuf[READ_NPY_HEADER_MAX];
+	const char	*s;
+	char		*e;
+	field_t		fi;
+	long long	dim[2], base, rN;
+	int		N, cN, hlen, size, order, fortran;
+
+	if (		fread(pre, 10, 1, fd) != 1
+			|| memcmp(pre, "\x93NUMPY", 6) != 0) {
+
+		ERROR("No NPY header in file \"%s\"\n", file);
+		return -1;
+	}
+
+	/* Header length is 16-bit in version 1 and 32-bit in later ones.
+	 * */
+	if (pre[6] == 1) {
+
+		hlen = pre[8] | (pre[9] << 8);
+		base = 10;
+	}
+	else {
+		if (fread(pre + 10, 2, 1, fd) != 1) {
+
+			ERROR("No NPY header in file \"%s\"\n", file);
+			return -1;
+		}
+
+		hlen = pre[8] | (pre[9] << 8) | (pre[10] << 16) | (pre[11] << 24);
+		base = 12;
+	}
+
+	if (hlen < 1 || hlen >= READ_NPY_HEADER_MAX) {
+
+		ERROR("NPY header of %i bytes is too long\n", hlen);
+		return -1;
+	}
+
+	if (fread(hbuf, hlen, 1, fd) != 1) {
+
+		ERROR("No NPY header in file \"%s\"\n", file);
+		return -1;
+	}
+
+	hbuf[hlen] = 0;
+	base += hlen;
+
+	s = npyKey(hbuf, "'descr'");
+
+	if (		s == NULL || s[0] != '\''
+			|| strchr("<>|=", s[1]) == NULL || s[2] == 0) {
+
+		ERROR("Unsupported NPY dtype in file \"%s\"\n", file);
+		return -1;
+	}
+
+	order = s[1];
+	size = (int) strtol(s + 3, &e, 10);
+
+	memset(&fi, 0, sizeof(fi));
+
+	if (s[2] == 'f' && (size == 4 || size == 8)) {
+
+		fi.type = (size == 4) ? FIELD_F32 : FIELD_F64;
+	}
+	else if (		(s[2] == 'i' || s[2] == 'u' || s[2] == 'b')
+			&& (size == 1 || size == 2 || size == 4 || size == 8)) {
+
+		N = (size == 1) ? 0 : (size == 2) ? 2 : (size == 4) ? 4 : 6;
+		fi.type = (s[2] == 'i') ? N + 1 : N;
+	}
+	else {
+		ERROR("Unsupported NPY dtype \"%.8s\" in file \"%s\"\n", s + 1, file);
+		return -1;
+	}
+
+	fi.swap = ((order == '<' && SDL_BYTEORDER == SDL_BIG_ENDIAN)
+			|| (order == '>' && SDL_BYTEORDER != SDL_BIG_ENDIAN)) ? 1 : 0;
+	fi.scale = 1.;
+
+	s = npyKey(hbuf, "'fortran_order'");
+	fortran = (s != NULL && strncmp(s, "True", 4) == 0) ? 1 : 0;
+
+	s = npyKey(hbuf, "'shape'");
+
+	if (s == NULL || *s != '(') {
+
+		ERROR("No NPY shape in file \"%s\"\n", file);
+		return -1;
+	}
+
+	dim[0] = 1;
+	dim[1] = 1;
+
+	for (N = 0, s++; *s != ')' && *s != 0; ) {
+
+		if (*s == ' ' || *s == ',') { s++; continue; }
+
+		if (N >= 2) {
+
+			ERROR("NPY array of more than 2 dimensions in \"%s\"\n", file);
+			return -1;
+		}
+
+		dim[N++] = strtoll(s, &e, 10);
+
+		if (e == s) {
+
+			ERROR("No NPY shape in file \"%s\"\n", file);
+			return -1;
+		}
+
+		s = e;
+	}
+
+	rN = dim[0];
+	cN = (int) dim[1];
+
+	if (		dim[0] < 0 || dim[0] > INT_MAX
+			|| dim[1] < 1 || dim[1] > READ_COLUMN_MAX) {
+
+		ERROR("NPY array shape (%lli, %lli) is out of range\n", dim[0], dim[1]);
+		return -1;
+	}
+
+	rd->data[dN].map = (char *) fmmap(file, &rd->data[dN].map_size);
+	rd->data[dN].map_alloc = 0;
+
+	if (rd->data[dN].map == NULL) {
+
+		/* We read the whole file if it cannot be mapped.
+		 * */
+		rd->data[dN].map_size = FILE_GetSize(file);
+		rd->data[dN].map = malloc(rd->data[dN].map_size + 1U);
+		rd->data[dN].map_alloc = 1;
+
+		fseek(fd, 0UL, SEEK_SET);
+
+		if (		rd->data[dN].map == NULL
+				|| fread(rd->data[dN].map, 1, rd->data[dN].map_size, fd)
+					!= rd->data[dN].map_size) {
+
+			ERROR("Unable to read file \"%s\"\n", file);
+			npyClose(rd, dN);
+			return -1;
+		}
+	}
+
+	/* Shape is taken from file so we compare by division that could
+	 * not overflow.
+	 * */
+	if (		(long long) rd->data[dN].map_size < base
+			|| rN > ((long long) rd->data[dN].map_size - base)
+				/ ((long long) cN * size)) {
+
+		ERROR("NPY payload is truncated in file \"%s\"\n", file);
+		npyClose(rd, dN);
+		return -1;
+	}
+
+	/* Fortran order is columnar so each column is a contiguous run of
+	 * values and the next row is one value further.
+	 * */
+	for (N = 0; N < cN; ++N) {
+
+		fi.offset = (fortran != 0) ? (long long) N * rN * size
+			: (long long) N * size;
+
+		rd->data[dN].field[N] = fi;
+	}
+
+	rd->data[dN].map_base = base;
+	rd->data[dN].map_step = (fortran != 0) ? size : (long long) cN * size;
+	rd->data[dN].map_row = 0;
+	rd->data[dN].map_N = rN;
+
+	return cN;
+}
+
+static int
+shmOpen(read_t *rd, int dN, const char *file, int fmt, int cN)
+{
+	const shm_ring_t	*ring = (const shm_ring_t *) rd->data[dN].map;
+	field_t			fi;
+	int			N;
+
+	if (fmt == FORMAT_BINARY_FLOAT || fmt == FORMAT_BINARY_DOUBLE) {
+
+		memset(&fi, 0, sizeof(fi));
+
+		fi.type = (fmt == FORMAT_BINARY_FLOAT) ? FIELD_F32 : FIELD_F64;
+
+		for (N = 0; N < cN; ++N) {
+
+			fi.offset = (long long) N * field_size[fi.type];
+			rd->data[dN].field[N] = fi;
+		}
+
+		rd->data[dN].record = cN * field_size[fi.type];
+	}
+	else if (fmt != FORMAT_BINARY_STRUCT && fmt != FORMAT_BINARY_SHM) {
+
+		ERROR("Shared memory \"%s\" needs binary row format\n", file);
+		return -1;
+	}
+
+	if (		rd->data[dN].map_size < sizeof(shm_ring_t)
+			|| memcmp(ring->magic, READ_SHM_MAGIC, sizeof(READ_SHM_MAGIC)) != 0) {
+
+		ERROR("No ring header in shared memory \"%s\"\n", file);
+		return -1;
+	}
+
+	if (ring->row_size != (unsigned int) rd->data[dN].record) {
+
+		ERROR("Ring row of %u bytes does not match the format of %i bytes\n",
+				ring->row_size, rd->data[dN].record);
+		return -1;
+	}
+
+	if (		ring->header_size < sizeof(shm_ring_t)
+			|| ring->header_size > rd->data[dN].map_size
+			|| ring->capacity < 1
+			|| ring->capacity > (rd->data[dN].map_size
+				- ring->header_size) / ring->row_size) {
+
+		ERROR("Ring is out of shared memory \"%s\"\n", file);
+		return -1;
+	}
+
+	rd->data[dN].map_base = ring->header_size;
+	rd->data[dN].map_step = ring->row_size;
+	rd->data[dN].shm_capacity = ring->capacity;
+
+	/* We continue from where the previous reader has stopped.
+	 * */
+	rd->data[dN].map_row = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	rd->data[dN].map_N = rd->data[dN].map_row;
+
+	rd->data[dN].shm_timeout = rd->timeout;
+	rd->data[dN].shm_tick = (int) SDL_GetTicks();
+
+	return cN;
+}
+
+static void
+shmRelease(read_t *rd, int dN)
+{
+	shm_ring_t	*ring = (shm_ring_t *) rd->data[dN].map;
+	long long	tail;
+
+	/* Stride may take us past the rows we have got.
+	 * */
+	tail = (rd->data[dN].map_row < rd->data[dN].map_N)
+		? rd->data[dN].map_row : rd->data[dN].map_N;
+
+	__atomic_store_n(&ring->tail, (unsigned long long) tail, __ATOMIC_RELEASE);
+}
+
+static void
+readClose(read_t *rd, int dN)
+{
+	if (rd->data[dN].afd != NULL) {
+
+		async_close(rd->data[dN].afd);
+	}
+
+	if (rd->data[dN].fd != stdin) {
+
+		fclose(rd->data[dN].fd);
+	}
+
+	if (		rd->data[dN].format == FORMAT_BINARY_SHM
+			&& rd->data[dN].map != NULL) {
+
+		shmRelease(rd, dN);
+	}
+
+	npyClose(rd, dN);
+
+	rd->data[dN].fd = NULL;
+	rd->data[dN].afd = NULL;
+	rd->data[dN].deferred = 0;
+
+	rd->files_N -= 1;
+}
+
+void readClean(read_t *rd)
+{
+	int		dN;
+
+	/* Reader threads use dataset settings so stop them first.
+	 * */
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (rd->data[dN].fd != NULL) {
+
+			readClose(rd, dN);
+		}
+
+		indexClean(rd, dN);
+	}
+
+	free(rd);
+}
+
+static async_FILE *
+readStartText(read_t *rd, int dN, async_lz4_t *lz, async_sock_t *sk, ulen_t sF)
+{
+	text_parse_t	*tp;
+	async_FILE	*afd;
+	FILE		*fd, *wfd[ASYNC_WORKERS_MAX];
+	int		N, wN, kN, cN;
+
+	fd = rd->data[dN].fd;
+	cN = rd->data[dN].column_N;
+
+	tp = calloc(1, sizeof(text_parse_t));
+
+	if (tp == NULL)
+		return NULL;
+
+	tp->rd = rd;
+	tp->dN = dN;
+
+	tp->line_N = 3;
+	tp->stride = rd->data[dN].stride;
+	tp->detect = 1;
+
+	if (		rd->data[dN].index_build == 0 && rd->data[dN].index_N != 0
+			&& rd->data[dN].window == 0 && tp->stride > 1
+			&& tp->stride % rd->index_step == 0) {
+
+		/* Stride is a multiple of index step so we take the
+		 * lines right from the index.
+		 * */
+		kN = tp->stride / rd->index_step;
+		N = rd->data[dN].index_N - rd->data[dN].index_first;
+
+		tp->stride = 1;
+
+		afd = async_open_sample(fd, rd->data[dN].index + rd->data[dN].index_first,
+				(N + kN - 1) / kN, kN, rd->preload, (async_parse_t) &TEXT_Parse,
+				tp, sizeof(rd->data[0].buf), cN * sizeof(fval_t));
+
+		if (afd == NULL) {
+
+			free(tp);
+		}
+
+		return afd;
+	}
+
+	/* Large regular file is parsed by a number of workers.
+	 * */
+	wN = 0;
+
+	if (sF != 0 && rd->data[dN].follow == 0 && rd->data[dN].stride <= 1) {
+
+		wN = (int) (sF / ASYNC_BLOCK_SIZE);
+		wN = (wN > SDL_GetCPUCount()) ? SDL_GetCPUCount() : wN;
+		wN = (wN > ASYNC_WORKERS_MAX) ? ASYNC_WORKERS_MAX : wN;
+
+		for (N = 0; N < wN; ++N) {
+
+			wfd[N] = unified_fopen(rd->data[dN].file, "rb");
+
+			if (wfd[N] == NULL)
+				break;
+		}
+
+		if (N < wN) {
+
+			while (N > 0) { fclose(wfd[--N]); }
+		}
+
+		wN = N;
+	}
+
+	if (wN >= 2) {
+
+		tp->detect = 0;
+
+		afd = async_open_chunked(fd, wfd, wN, rd->preload,
+				rd->chunk, rd->timeout, (async_parse_t) &TEXT_Parse,
+				tp, sizeof(rd->data[0].buf), cN * sizeof(fval_t));
+	}
+	else {
+		if (wN == 1) { fclose(wfd[0]); }
+
+		afd = async_open_parse(fd, lz, sk, rd->preload, rd->chunk,
+				rd->timeout, (async_parse_t) &TEXT_Parse, tp,
+				sizeof(rd->data[0].buf), cN * sizeof(fval_t));
+	}
+
+	if (afd == NULL) {
+
+		free(tp);
+	}
+
+	return afd;
+}
+
+void readOpenUnified(read_t *rd, int dN, int cN, int lN, const char *file, int fmt)
+{
+	fval_t		rbuf[READ_COLUMN_MAX * 3];
+	field_t		tfi;
+	FILE		*fd = NULL;
+	async_lz4_t	*lz = NULL;
+	async_sock_t	*sk = NULL;
+	ulen_t		sF = 0U;
+	long long	base = 0, lo, hi, rN;
+	int		N, record = 0, type = FIELD_F32, stride, shm = 0;
+
+	if (rd->data[dN].fd != NULL) {
+
+		readClose(rd, dN);
+	}
+
+	if (file != NULL && async_sock_name(file) != 0) {
+
+		sk = async_sock_open(file, rd->preload);
+
+		/* We keep the socket in FILE just to close it later.
+		 * */
+		fd = (sk != NULL) ? fdopen(sk->sock, "rb") : NULL;
+
+		if (sk != NULL && fd == NULL) {
+
+			ERROR("fdopen(\"%s\"): %s\n", file, strerror(errno));
+			async_sock_close(sk);
+			return ;
+		}
+	}
+	else if (file != NULL && strncmp(file, "shm:", 4) == 0) {
+
+		fd = fshmopen(file + 4, (void **) &rd->data[dN].map,
+				&rd->data[dN].map_size);
+
+		rd->data[dN].map_alloc = 0;
+
+		shm = 1;
+	}
+	else if (file != NULL) {
+
+		fd = unified_fopen(file, "rb");
+	}
+	else if (fmt == FORMAT_PLAIN_TEXT) {
+
+		fd = stdin;
+	}
+
+	if (fd == NULL) {
+
+		if (sk == NULL) {
+
+			ERROR("fopen(\"%s\"): %s\n", file, strerror(errno));
+		}
+	}
+	else {
+		if (file != NULL && sk == NULL && shm == 0) {
+
+			sF = FILE_GetSize(file);
+		}
+
+		if (rd->data[dN].follow != 0 && sF != 0) {
+
+			fseek(fd, 0UL, SEEK_END);
+		}
+
+		rd->data[dN].length_N = lN;
+
+		stride = (rd->data[dN].stride > 1) ? rd->data[dN].stride : 1;
+
+		if (shm != 0) {
+
+			cN = shmOpen(rd, dN, file, fmt, cN);
+
+			if (cN < 1) {
+
+				npyClose(rd, dN);
+				fclose(fd);
+				return ;
+			}
+
+			fmt = FORMAT_BINARY_SHM;
+		}
+
+		/* Only regular file is checked for NPY magic as reading
+		 * from a device or socket takes away the data.
+		 * */
+		if (		fmt == FORMAT_PLAIN_TEXT && sF != 0
+				&& rd->data[dN].follow == 0 && npyCheck(fd) != 0) {
+
+			fmt = FORMAT_BINARY_NPY;
+		}
+
+		if (		sF != 0 && rd->data[dN].follow == 0
+				&& (fmt == FORMAT_PLAIN_TEXT || fmt == FORMAT_BINARY_FLOAT
+					|| fmt == FORMAT_BINARY_DOUBLE
+					|| fmt == FORMAT_BINARY_STRUCT)) {
+
+			lz = async_lz4_open(fd);
+
+			if (lz != NULL) {
+
+				/* Compressed file size says nothing about
+				 * the data length and we are unable to seek.
+				 * */
+				sF = 0U;
+			}
+		}
+
+		if (fmt == FORMAT_PLAIN_TEXT) {
+
+			cN = TEXT_GetCN(rd, dN, fd, lz, sk, rbuf);
+
+			if (cN < 1) {
+
+				ERROR("No correct data in file \"%s\"\n",
+						(file != NULL) ? file : "STDIN");
+
+				if (lz != NULL) {
+
+					async_lz4_close(lz);
+				}
+
+				if (sk != NULL) {
+
+					async_sock_close(sk);
+				}
+
+				fclose(fd);
+				return ;
+			}
+
+			if (		sF != 0 && rd->data[dN].follow == 0
+					&& lz == NULL) {
+
+				TEXT_ProbeHint(rd, dN, fd);
+			}
+		}
+		else if (fmt == FORMAT_BINARY_NPY) {
+
+			cN = (file != NULL && sk == NULL) ? npyOpen(rd, dN, fd, file) : -1;
+
+			if (cN < 1) {
+
+				if (sk != NULL) {
+
+					async_sock_close(sk);
+				}
+
+				fclose(fd);
+				return ;
+			}
+		}
+
+		if (		rd->data[dN].window != 0
+				&& (rd->data[dN].window_cN < 0 || rd->data[dN].window_cN >= cN)) {
+
+			ERROR("Window column %i is out of range\n", rd->data[dN].window_cN);
+			rd->data[dN].window = 0;
+		}
+
+		if (fmt == FORMAT_PLAIN_TEXT) {
+
+			indexClean(rd, dN);
+
+			if (		rd->index_step > 0 && file != NULL
+					&& rd->data[dN].follow == 0 && lz == NULL && sk == NULL) {
+
+				rd->data[dN].column_N = cN;
+
+				if (indexLoad(rd, dN, file, async_tell(fd)) != 0) {
+
+					/* We build index only if all rows are read.
+					 * */
+					rd->data[dN].index_build = (stride == 1
+							&& rd->data[dN].window == 0) ? 1 : 0;
+				}
+				else if (rd->data[dN].window != 0) {
+
+					indexWindow(rd, dN, fd);
+				}
+				else if (rd->data[dN].length_N > 0) {
+
+					indexTail(rd, dN, fd, stride);
+				}
+			}
+
+			if (		rd->data[dN].index_build == 0 && rd->data[dN].index_N != 0
+					&& rd->data[dN].window == 0 && lN < 1) {
+
+				/* Index tells us how many rows are in file.
+				 * */
+				lN = (rd->data[dN].index_row + 3) / stride + 1;
+			}
+			else if (sF != 0 && lN < 1) {
+
+				/* We do not use the file size to guess the
+				 * length since there is an incremental dataset
+				 * memory allocation.
+				 * */
+				lN = 1000;
+			}
+			else if (lN < 1) {
+
+				lN = rd->length_N;
+			}
+		}
+		else if (fmt == FORMAT_BINARY_FLOAT) {
+
+			lN = (lN < 1) ? sF / (cN * sizeof(float)) : lN;
+			rd->data[dN].line_N = 1;
+
+			record = cN * sizeof(float);
+			type = FIELD_F32;
+		}
+		else if (fmt == FORMAT_BINARY_DOUBLE) {
+
+			lN = (lN < 1) ? sF / (cN * sizeof(double)) : lN;
+			rd->data[dN].line_N = 1;
+
+			record = cN * sizeof(double);
+			type = FIELD_F64;
+		}
+		else if (fmt == FORMAT_BINARY_STRUCT) {
+
+			record = rd->data[dN].record;
+
+			lN = (lN < 1) ? sF / record : lN;
+			rd->data[dN].line_N = 1;
+		}
+		else if (fmt == FORMAT_BINARY_NPY) {
+
+			lN = (lN < 1) ? rd->data[dN].map_N : lN;
+			rd->data[dN].line_N = 1;
+
+			record = rd->data[dN].map_step;
+			base = rd->data[dN].map_base;
+		}
+		else if (fmt == FORMAT_BINARY_SHM) {
+
+			/* Ring is unbounded so we grow as with sockets.
+			 * */
+			lN = (lN < 1) ? rd->length_N : lN;
+			rd->data[dN].line_N = 1;
+		}
+
+#ifdef _WINDOWS
+		else if (fmt == FORMAT_BINARY_LEGACY_V1) {
+
+			lN = (lN < 1) ? (sF - 6) / (cN * 6) : lN;
+			rd->data[dN].line_N = 1;
+
+			fseek(fd, 6UL, SEEK_SET);
+
+			record = cN * 6;
+			base = 6;
+		}
+		else if (fmt == FORMAT_BINARY_LEGACY_V2) {
+
+			lN = (lN < 1) ? (sF - 4) / (cN * 4) : lN;
+			rd->data[dN].line_N = 1;
+
+			fseek(fd, 4UL, SEEK_SET);
+
+			record = cN * 4;
+			base = 4;
+		}
+#endif /* _WINDOWS */
+
+		if (record != 0) {
+
+			if ((lz != NULL || sk != NULL) && lN < 1) {
+
+				lN = rd->length_N;
+			}
+
+			if (sk != NULL) {
+
+				sk->record = record;
+			}
+
+			if (		rd->data[dN].window != 0
+					&& rd->data[dN].follow == 0 && sF != 0) {
+
+				/* Records have fixed size so we look for the
+				 * window by bisection of time column.
+				 * */
+				if (		fmt == FORMAT_BINARY_STRUCT
+						|| fmt == FORMAT_BINARY_NPY) {
+
+					tfi = rd->data[dN].field[rd->data[dN].window_cN];
+				}
+				else {
+					memset(&tfi, 0, sizeof(tfi));
+
+					tfi.type = type;
+					tfi.offset = (record / cN) * (rd->data[dN].window_cN + 1)
+						- field_size[type];
+				}
+
+				rN = (fmt == FORMAT_BINARY_NPY) ? rd->data[dN].map_N
+					: (long long) (sF - base) / record;
+
+				lo = binaryBound(fd, base, record, &tfi, rN,
+						rd->data[dN].window_min, 0);
+
+				hi = binaryBound(fd, base, record, &tfi, rN,
+						rd->data[dN].window_max, 1);
+
+				async_seek(fd, base + lo * record);
+
+				if (fmt == FORMAT_BINARY_NPY) {
+
+					rd->data[dN].map_row = lo;
+					rd->data[dN].map_N = hi;
+				}
+
+				lN = (rd->data[dN].length_N < 1) ? (int) (hi - lo) : lN;
+			}
+
+			if (rd->data[dN].length_N < 1) {
+
+				lN = (lN + stride - 1) / stride;
+			}
+		}
+
+		plotDataAlloc(rd->pl, dN, cN, lN + 1);
+
+		if (fmt == FORMAT_PLAIN_TEXT) {
+
+			rd->data[dN].column_N = cN;
+
+			for (N = 0; N < 3; N += stride) {
+
+				if (readWindow(rd, dN, rbuf + READ_COLUMN_MAX * N) == 0) {
+
+					plotDataInsert(rd->pl, dN, rbuf + READ_COLUMN_MAX * N);
+				}
+			}
+		}
+
+		rd->data[dN].format = fmt;
+		rd->data[dN].column_N = cN;
+
+		/* Projection needs to read the file again if other columns
+		 * are referenced so we apply it to regular files only.
+		 * */
+		rd->data[dN].projection = (rd->projection != 0
+				&& fmt == FORMAT_PLAIN_TEXT && sF != 0 && lz == NULL
+				&& sk == NULL && rd->data[dN].follow == 0) ? 1 : 0;
+
+		rd->data[dN].deferred = (rd->data[dN].projection != 0
+				&& rd->config_busy != 0) ? 1 : 0;
+
+		if (		rd->data[dN].projection != 0
+				&& rd->data[dN].deferred == 0) {
+
+			projectionMask(rd, dN, rd->data[dN].used);
+		}
+
+		if (file != rd->data[dN].file) {
+
+			/* Dataset reload takes the file name from here.
+			 * */
+			strcpy(rd->data[dN].file, (file != NULL) ? file : "STDIN");
+		}
+
+		rd->data[dN].fd = fd;
+
+		if (fmt == FORMAT_PLAIN_TEXT) {
+
+			if (rd->data[dN].deferred == 0) {
+
+				rd->data[dN].afd = readStartText(rd, dN, lz, sk, sF);
+			}
+			else {
+				rd->data[dN].afd = NULL;
+			}
+		}
+		else if (fmt == FORMAT_BINARY_NPY || fmt == FORMAT_BINARY_SHM) {
+
+			/* Rows are taken directly from the mapping.
+			 * */
+			rd->data[dN].afd = NULL;
+		}
+		else if (stride > 1) {
+
+			rd->data[dN].afd = async_open_stride(fd, lz, sk, rd->preload,
+					rd->timeout, record, stride);
+		}
+		else {
+			rd->data[dN].afd = async_open(fd, lz, sk, rd->preload, rd->chunk, rd->timeout);
+		}
+
+		if (		rd->data[dN].afd == NULL
+				&& rd->data[dN].deferred == 0
+				&& fmt != FORMAT_BINARY_NPY && fmt != FORMAT_BINARY_SHM) {
+
+			/* Reader was not started so dataset is left empty.
+			 * */
+			if (lz != NULL) {
+
+				async_lz4_close(lz);
+			}
+
+			if (sk != NULL) {
+
+				async_sock_close(sk);
+			}
+
+			if (fd != stdin) {
+
+				fclose(fd);
+			}
+
+			rd->data[dN].fd = NULL;
+			return ;
+		}
+
+		rd->data[dN].live = (sF == 0 || rd->data[dN].follow != 0) ? 1 : 0;
+
+		rd->files_N += 1;
+		rd->bind_N = dN;
+	}
+}
+
+void readOpenStub(read_t *rd, int dN, int cN, int lN, const char *file, int fmt)
+{
+	rd->data[dN].length_N = lN;
+
+	lN = (lN < 1) ? 10 : lN;
+
+	plotDataAlloc(rd->pl, dN, cN, lN + 1);
+
+	rd->data[dN].format = fmt;
+	rd->data[dN].column_N = cN;
+
+	strcpy(rd->data[dN].file, file);
+
+	rd->bind_N = dN;
+}
+
+void readToggleHint(read_t *rd, int dN, int cN)
+{
+	int		ht;
+
+	if (rd->data[dN].format == FORMAT_NONE) {
+
+		ERROR("Dataset number %i was not allocated\n", dN);
+		return ;
+	}
+
+	if (cN < 0 || cN >= rd->data[dN].column_N) {
+
+		return ;
+	}
+
+	ht = SDL_AtomicGet(&rd->data[dN].hint[cN]);
+
+	if (ht == DATA_HINT_NONE) {
+
+		ht = DATA_HINT_FLOAT;
+	}
+	else if (ht == DATA_HINT_FLOAT) {
+
+		ht = DATA_HINT_HEX;
+	}
+	else if (ht == DATA_HINT_HEX) {
+
+		ht = DATA_HINT_OCT;
+	}
+	else if (ht == DATA_HINT_OCT) {
+
+		ht = DATA_HINT_NONE;
+	}
+
+	/* Reader takes the new hint from the next row on.
+	 * */
+	SDL_AtomicSet(&rd->data[dN].hint[cN], ht);
+}
+
+static int
+TEXT_Read(read_t *rd, int dN)
+{
+	fval_t		*row;
+	int		r;
+
+	/* Row was parsed on the reader thread.
+	 * */
+	r = async_row(rd->data[dN].afd, (void **) &row);
+
+	if (r == ASYNC_OK) {
+
+		if (rd->data[dN].index_build != 0) {
+
+			if (rd->data[dN].index_row % rd->index_step == 0) {
+
+				indexAppend(rd, dN, async_row_offset(rd->data[dN].afd, row));
+			}
+
+			rd->data[dN].index_row++;
+		}
+
+		plotDataInsert(rd->pl, dN, row);
+		async_row_done(rd->data[dN].afd);
+
+		return 1;
+	}
+	else if (r == ASYNC_END_OF_FILE) {
+
+		if (rd->data[dN].index_build != 0) {
+
+			indexSave(rd, dN);
+		}
 
 		readClose(rd, dN);
 	}
@@ -980,6 +2643,29 @@ TEXT_Read(read_t *rd, int dN)
 	return 0;
 }
 
+static int
+BINARY_Insert(read_t *rd, int dN)
+{
+	int		r;
+
+	r = readWindow(rd, dN, rd->data[dN].row);
+
+	if (r == 0) {
+
+		plotDataInsert(rd->pl, dN, rd->data[dN].row);
+	}
+	else if (r > 0) {
+
+		/* Time is past the window so we are done.
+		 * */
+		readClose(rd, dN);
+
+		return 0;
+	}
+
+	return 1;
+}
+
 static int
 FLOAT_Read(read_t *rd, int dN)
 {
@@ -993,9 +2679,7 @@ FLOAT_Read(read_t *rd, int dN)
 		for (N = 0; N < cN; ++N)
 			rd->data[dN].row[N] = (fval_t) fb[N];
 
-		plotDataInsert(rd->pl, dN, rd->data[dN].row);
-
-		return 1;
+		return BINARY_Insert(rd, dN);
 	}
 	else if (r == ASYNC_END_OF_FILE) {
 
@@ -1018,9 +2702,31 @@ DOUBLE_Read(read_t *rd, int dN)
 		for (N = 0; N < cN; ++N)
 			rd->data[dN].row[N] = (fval_t) fb[N];
 
-		plotDataInsert(rd->pl, dN, rd->data[dN].row);
+		return BINARY_Insert(rd, dN);
+	}
+	else if (r == ASYNC_END_OF_FILE) {
 
-		return 1;
+		readClose(rd, dN);
+	}
+
+	return 0;
+}
+
+static int
+STRUCT_Read(read_t *rd, int dN)
+{
+	const field_t	*fi = rd->data[dN].field;
+	const char	*fb = (const char *) rd->data[dN].buf;
+	int		r, N, cN = rd->pl->data[dN].column_N;
+
+	r = async_read(rd->data[dN].afd, (void *) fb, rd->data[dN].record);
+
+	if (r == ASYNC_OK) {
+
+		for (N = 0; N < cN; ++N)
+			rd->data[dN].row[N] = (fval_t) fieldValue(fi + N, fb + fi[N].offset);
+
+		return BINARY_Insert(rd, dN);
 	}
 	else if (r == ASYNC_END_OF_FILE) {
 
@@ -1030,6 +2736,85 @@ DOUBLE_Read(read_t *rd, int dN)
 	return 0;
 }
 
+static int
+NPY_Read(read_t *rd, int dN)
+{
+	const field_t	*fi = rd->data[dN].field;
+	const char	*fb;
+	int		N, cN = rd->pl->data[dN].column_N;
+
+	if (rd->data[dN].map_row >= rd->data[dN].map_N) {
+
+		readClose(rd, dN);
+		return 0;
+	}
+
+	fb = rd->data[dN].map + rd->data[dN].map_base
+		+ rd->data[dN].map_row * rd->data[dN].map_step;
+
+	for (N = 0; N < cN; ++N)
+		rd->data[dN].row[N] = (fval_t) fieldValue(fi + N, fb + fi[N].offset);
+
+	rd->data[dN].map_row += (rd->data[dN].stride > 1) ? rd->data[dN].stride : 1;
+
+	return BINARY_Insert(rd, dN);
+}
+
+static int
+SHM_Read(read_t *rd, int dN)
+{
+	shm_ring_t	*ring = (shm_ring_t *) rd->data[dN].map;
+	const field_t	*fi = rd->data[dN].field;
+	const char	*fb;
+	long long	head, batch;
+	int		N, closed, cN = rd->pl->data[dN].column_N;
+
+	if (rd->data[dN].map_row >= rd->data[dN].map_N) {
+
+		shmRelease(rd, dN);
+
+		/* Look at the closed flag first so we do not miss the rows
+		 * that were written just before it.
+		 * */
+		closed = __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE);
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+		if (rd->data[dN].map_row >= head) {
+
+			if (		closed != 0
+					|| (int) SDL_GetTicks() - rd->data[dN].shm_tick
+						>= rd->data[dN].shm_timeout) {
+
+				readClose(rd, dN);
+			}
+
+			return 0;
+		}
+
+		/* Space is given back at least four times per ring so the
+		 * producer does not stall on a long batch.
+		 * */
+		batch = rd->data[dN].shm_capacity / 4;
+		batch = (batch < 1) ? 1 : batch;
+
+		rd->data[dN].map_N = (head - rd->data[dN].map_row > batch)
+			? rd->data[dN].map_row + batch : head;
+
+		rd->data[dN].shm_tick = (int) SDL_GetTicks();
+	}
+
+	fb = rd->data[dN].map + rd->data[dN].map_base
+		+ (rd->data[dN].map_row % rd->data[dN].shm_capacity)
+		* rd->data[dN].map_step;
+
+	for (N = 0; N < cN; ++N)
+		rd->data[dN].row[N] = (fval_t) fieldValue(fi + N, fb + fi[N].offset);
+
+	rd->data[dN].map_row += (rd->data[dN].stride > 1) ? rd->data[dN].stride : 1;
+
+	return BINARY_Insert(rd, dN);
+}
+
 #ifdef _WINDOWS
 static int
 LEGACY_Read(read_t *rd, int dN)
@@ -1057,9 +2842,7 @@ LEGACY_Read(read_t *rd, int dN)
 				rd->data[dN].row[N] = * (float *) (fb + N * 4);
 		}
 
-		plotDataInsert(rd->pl, dN, rd->data[dN].row);
-
-		return 1;
+		return BINARY_Insert(rd, dN);
 	}
 	else if (r == ASYNC_END_OF_FILE) {
 
@@ -1076,7 +2859,20 @@ int readUpdate(read_t *rd)
 	int		dN, bN;
 	int		file_N = 0;
 	int		ulN = 0;
-	int		tTOP;
+	int		tTOP, tSLICE;
+
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (rd->data[dN].fd != NULL)
+			file_N += 1;
+	}
+
+	/* Read budget is shared between all of the open files.
+	 * */
+	tSLICE = (file_N > 0) ? rd->read_budget / file_N : 0;
+	tSLICE = (tSLICE < 1) ? 1 : tSLICE;
+
+	file_N = 0;
 
 	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
 
@@ -1087,7 +2883,7 @@ int readUpdate(read_t *rd)
 			bN = 0;
 			file_N += 1;
 
-			tTOP = SDL_GetTicks() + 20;
+			tTOP = SDL_GetTicks() + tSLICE;
 
 			do {
 				if (rd->data[dN].format == FORMAT_PLAIN_TEXT) {
@@ -1120,39 +2916,168 @@ int readUpdate(read_t *rd)
 						break;
 					}
 				}
+				else if (rd->data[dN].format == FORMAT_BINARY_STRUCT) {
+
+					if (STRUCT_Read(rd, dN) != 0) {
+
+						ulN += 1;
+					}
+					else {
+						break;
+					}
+				}
+				else if (rd->data[dN].format == FORMAT_BINARY_NPY) {
+
+					if (NPY_Read(rd, dN) != 0) {
+
+						ulN += 1;
+					}
+					else {
+						break;
+					}
+				}
+				else if (rd->data[dN].format == FORMAT_BINARY_SHM) {
+
+					if (SHM_Read(rd, dN) != 0) {
+
+						ulN += 1;
+					}
+					else {
+						break;
+					}
+				}
 
 #ifdef _WINDOWS
 				else if (rd->data[dN].format == FORMAT_BINARY_LEGACY_V1
 					|| rd->data[dN].format == FORMAT_BINARY_LEGACY_V2) {
 
-					if (LEGACY_Read(rd, dN) != 0) {
+					if (LEGACY_Read(rd, dN) != 0) {
+
+						ulN += 1;
+					}
+					else {
+						break;
+					}
+				}
+#endif /* _WINDOWS */
+
+				rd->data[dN].line_N++;
+				bN++;
+
+				if (		rd->data[dN].length_N < 1
+						&& plotDataSpaceLeft(rd->pl, dN) < 10) {
+
+					plotDataGrowUp(rd->pl, dN);
+				}
+			}
+			while (SDL_GetTicks() < tTOP);
+
+			plotDataSubtract(rd->pl, dN, -1);
+		}
+	}
+
+	rd->files_N = (file_N < rd->files_N) ? file_N : rd->files_N;
+
+	return ulN;
+}
+
+void readUpdateAll(read_t *rd)
+{
+	int		dN, tEND;
+
+	/* Do not wait for the file to grow as we need all of the data now.
+	 * */
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (rd->data[dN].afd != NULL) {
+
+			rd->data[dN].afd->timeout = 0;
+		}
+
+		if (rd->data[dN].format == FORMAT_BINARY_SHM) {
+
+			rd->data[dN].shm_timeout = 0;
+		}
+	}
+
+	tEND = SDL_GetTicks() + rd->timeout;
+
+	while (rd->files_N != 0) {
+
+		if (readUpdate(rd) == 0) {
+
+			SDL_Delay(1);
+		}
+
+		if (SDL_GetTicks() > tEND) {
 
-						ulN += 1;
-					}
-					else {
-						break;
-					}
-				}
-#endif /* _WINDOWS */
+			/* Live source may never come to the end so we take
+			 * what has arrived within the timeout.
+			 * */
+			readUpdate(rd);
 
-				rd->data[dN].line_N++;
-				bN++;
+			for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
 
-				if (		rd->data[dN].length_N < 1
-						&& plotDataSpaceLeft(rd->pl, dN) < 10) {
+				if (		rd->data[dN].fd != NULL
+						&& rd->data[dN].live != 0) {
 
-					plotDataGrowUp(rd->pl, dN);
+					readClose(rd, dN);
 				}
 			}
-			while (SDL_GetTicks() < tTOP);
 
-			plotDataSubtract(rd->pl, dN, -1);
+			tEND = SDL_GetTicks() + rd->timeout;
 		}
 	}
+}
+
+int readPolled(read_t *rd)
+{
+	int		dN;
+
+	/* Shared memory ring gives no notice of new rows so we have to
+	 * look at it periodically.
+	 * */
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (		rd->data[dN].fd != NULL
+				&& rd->data[dN].format == FORMAT_BINARY_SHM)
+			return 1;
+	}
 
-	rd->files_N = (file_N < rd->files_N) ? file_N : rd->files_N;
+	return 0;
+}
 
-	return ulN;
+void readProjection(read_t *rd)
+{
+	int		used[READ_COLUMN_MAX];
+	int		dN, N;
+
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (		rd->data[dN].projection == 0
+				|| rd->data[dN].format != FORMAT_PLAIN_TEXT)
+			continue;
+
+		memset(used, 0, sizeof(used));
+
+		projectionMask(rd, dN, used);
+
+		for (N = 0; N < rd->data[dN].column_N; ++N) {
+
+			if (used[N] != 0 && rd->data[dN].used[N] == 0)
+				break;
+		}
+
+		if (N < rd->data[dN].column_N) {
+
+			/* Column was referenced that we did not convert so
+			 * we have to read the file again.
+			 * */
+			readOpenUnified(rd, dN, rd->data[dN].column_N,
+					rd->data[dN].length_N, rd->data[dN].file,
+					rd->data[dN].format);
+		}
+	}
 }
 
 static int
@@ -1727,6 +3652,8 @@ configParseFSM(read_t *rd, parse_t *pa)
 						failed = 0;
 						strcpy(rd->mk_text.space, rd->mk_config.space);
 						strcat(rd->mk_text.space, tbuf);
+
+						markupUpdate(&rd->mk_text);
 					}
 				}
 				while (0);
@@ -1758,6 +3685,108 @@ configParseFSM(read_t *rd, parse_t *pa)
 				}
 				while (0);
 			}
+			else if (strcmp(tbuf, "stride") == 0) {
+
+				failed = 1;
+
+				do {
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0 && stoi(&rd->mk_config, &argi[0], tbuf) != NULL) ;
+					else break;
+
+					if (argi[0] >= 1) {
+
+						failed = 0;
+						rd->stride = argi[0];
+					}
+					else {
+						sprintf(msg_tbuf, "stride %i must be positive", argi[0]);
+					}
+				}
+				while (0);
+			}
+			else if (strcmp(tbuf, "window") == 0) {
+
+				failed = 1;
+
+				do {
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0 && stoi(&rd->mk_config, &argi[0], tbuf) != NULL) ;
+					else break;
+
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0 && stod(&rd->mk_config, argd + 0, tbuf) != NULL) ;
+					else break;
+
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0 && stod(&rd->mk_config, argd + 1, tbuf) != NULL) ;
+					else break;
+
+					if (argi[0] >= -1 && argi[0] < READ_COLUMN_MAX) {
+
+						failed = 0;
+						rd->window_cN = argi[0];
+						rd->window_min = argd[0];
+						rd->window_max = argd[1];
+					}
+					else {
+						sprintf(msg_tbuf, "window column %i is out of range", argi[0]);
+					}
+				}
+				while (0);
+			}
+			else if (strcmp(tbuf, "index") == 0) {
+
+				failed = 1;
+
+				do {
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0 && stoi(&rd->mk_config, &argi[0], tbuf) != NULL) ;
+					else break;
+
+					if (argi[0] >= 0) {
+
+						failed = 0;
+						rd->index_step = argi[0];
+					}
+					else {
+						sprintf(msg_tbuf, "index step %i must be non-negative", argi[0]);
+					}
+				}
+				while (0);
+			}
+			else if (strcmp(tbuf, "projection") == 0) {
+
+				failed = 1;
+
+				do {
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0 && stoi(&rd->mk_config, &argi[0], tbuf) != NULL) ;
+					else break;
+
+					if (rd->bind_N != -1) {
+
+						sprintf(msg_tbuf, "unable if dataset was already opened");
+						break;
+					}
+
+					if (argi[0] >= 0 && argi[0] < 2) {
+
+						failed = 0;
+						rd->projection = argi[0];
+					}
+					else {
+						sprintf(msg_tbuf, "invalid projection %i", argi[0]);
+					}
+				}
+				while (0);
+			}
 			else if (strcmp(tbuf, "load") == 0 || strcmp(tbuf, "follow") == 0) {
 
 				failed = 1;
@@ -1798,6 +3827,14 @@ configParseFSM(read_t *rd, parse_t *pa)
 
 							argi[2] = FORMAT_BINARY_DOUBLE;
 						}
+						else if (strcmp(tbuf, "struct") == 0) {
+
+							argi[2] = FORMAT_BINARY_STRUCT;
+						}
+						else if (strcmp(tbuf, "npy") == 0) {
+
+							argi[2] = FORMAT_BINARY_NPY;
+						}
 						else {
 							sprintf(msg_tbuf, "invalid file format \"%.80s\"", tbuf);
 							break;
@@ -1815,6 +3852,18 @@ configParseFSM(read_t *rd, parse_t *pa)
 
 						flag_stub = 1;
 					}
+					else if (argi[2] == FORMAT_BINARY_STRUCT) {
+
+						r = configLexerFSM(rd, pa);
+
+						if (r != 0) break;
+
+						argi[3] = structParse(rd, argi[0], tbuf, msg_tbuf);
+
+						if (argi[3] < 1) break;
+
+						flag_stub = 1;
+					}
 
 					r = configLexerFSM(rd, pa);
 
@@ -1822,6 +3871,12 @@ configParseFSM(read_t *rd, parse_t *pa)
 
 						rd->data[argi[0]].follow = flag_follow;
 
+						rd->data[argi[0]].stride = rd->stride;
+						rd->data[argi[0]].window = (rd->window_cN >= 0) ? 1 : 0;
+						rd->data[argi[0]].window_cN = rd->window_cN;
+						rd->data[argi[0]].window_min = rd->window_min;
+						rd->data[argi[0]].window_max = rd->window_max;
+
 						readOpenUnified(rd, argi[0], argi[3], argi[1], tbuf, argi[2]);
 
 						if (		rd->data[argi[0]].fd == NULL
@@ -2173,6 +4228,7 @@ configParseFSM(read_t *rd, parse_t *pa)
 
 							rd->page[rd->page_N].fig[rd->figure_N].busy = 1;
 							rd->page[rd->page_N].fig[rd->figure_N].drawing = -1;
+							rd->page[rd->page_N].fig[rd->figure_N].persist = FIGURE_PERSIST_DISABLED;
 							rd->page[rd->page_N].fig[rd->figure_N].dN = rd->bind_N;
 							rd->page[rd->page_N].fig[rd->figure_N].cX = argi[0];
 							rd->page[rd->page_N].fig[rd->figure_N].cY = argi[1];
@@ -2276,6 +4332,8 @@ configParseFSM(read_t *rd, parse_t *pa)
 							argi[0] = FIGURE_DRAWING_DASH;
 						else if (strcmp(tbuf, "dot") == 0)
 							argi[0] = FIGURE_DRAWING_DOT;
+						else if (strcmp(tbuf, "density") == 0)
+							argi[0] = FIGURE_DRAWING_DENSITY;
 						else {
 							sprintf(msg_tbuf, "invalid drawing \"%.80s\"", tbuf);
 							break;
@@ -2308,6 +4366,68 @@ configParseFSM(read_t *rd, parse_t *pa)
 				}
 				while (0);
 			}
+			else if (strcmp(tbuf, "persist") == 0) {
+
+				failed = 1;
+
+				do {
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0) {
+
+						if (strcmp(tbuf, "period") == 0)
+							argi[0] = FIGURE_PERSIST_PERIOD;
+						else if (strcmp(tbuf, "trigger") == 0)
+							argi[0] = FIGURE_PERSIST_TRIGGER;
+						else {
+							sprintf(msg_tbuf, "invalid persistence \"%.80s\"", tbuf);
+							break;
+						}
+					}
+					else break;
+
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0 && stod(&rd->mk_config, &argd[0], tbuf) != NULL) ;
+					else break;
+
+					r = configLexerFSM(rd, pa);
+
+					if (r == 0 && stod(&rd->mk_config, &argd[1], tbuf) != NULL) ;
+					else break;
+
+					if (rd->figure_N == -1) {
+
+						sprintf(msg_tbuf, "no figure selected");
+						break;
+					}
+
+					if (argi[0] == FIGURE_PERSIST_PERIOD && argd[0] <= 0.) {
+
+						sprintf(msg_tbuf, "persistence period %.4E is out of range", argd[0]);
+						break;
+					}
+
+					if (argi[0] == FIGURE_PERSIST_TRIGGER && argd[0] < 0.) {
+
+						sprintf(msg_tbuf, "trigger column %i is out of range", (int) argd[0]);
+						break;
+					}
+
+					if (argd[1] > 0. && argd[1] <= 1.) {
+
+						failed = 0;
+						rd->page[rd->page_N].fig[rd->figure_N].persist = argi[0];
+						rd->page[rd->page_N].fig[rd->figure_N].persist_column = (int) argd[0];
+						rd->page[rd->page_N].fig[rd->figure_N].persist_period = argd[0];
+						rd->page[rd->page_N].fig[rd->figure_N].persist_decay = argd[1];
+					}
+					else {
+						sprintf(msg_tbuf, "persistence decay %.4E is out of range", argd[1]);
+					}
+				}
+				while (0);
+			}
 			else {
 				failed = 1;
 
@@ -2329,6 +4449,33 @@ configParseFSM(read_t *rd, parse_t *pa)
 	while (1);
 }
 
+static void
+readDeferred(read_t *rd)
+{
+	int		dN;
+
+	/* Now all of the figures are known so we build the projection
+	 * mask and start the readers.
+	 * */
+	for (dN = 0; dN < PLOT_DATASET_MAX; ++dN) {
+
+		if (rd->data[dN].fd == NULL || rd->data[dN].deferred == 0)
+			continue;
+
+		rd->data[dN].deferred = 0;
+
+		projectionMask(rd, dN, rd->data[dN].used);
+
+		rd->data[dN].afd = readStartText(rd, dN, NULL, NULL,
+				FILE_GetSize(rd->data[dN].file));
+
+		if (rd->data[dN].afd == NULL) {
+
+			readClose(rd, dN);
+		}
+	}
+}
+
 void readConfigGP(read_t *rd, const char *file)
 {
 	FILE		*fd;
@@ -2348,9 +4495,15 @@ void readConfigGP(read_t *rd, const char *file)
 		pa.line_N = 1;
 		pa.newline = 1;
 
+		rd->config_busy = 1;
+
 		configParseFSM(rd, &pa);
 
+		rd->config_busy = 0;
+
 		fclose(fd);
+
+		readDeferred(rd);
 	}
 }
 
@@ -2523,6 +4676,7 @@ void readMakePages(read_t *rd, int dN, int cX, int fromUI)
 
 		rd->page[pN].fig[0].busy = 1;
 		rd->page[pN].fig[0].drawing = -1;
+		rd->page[pN].fig[0].persist = FIGURE_PERSIST_DISABLED;
 		rd->page[pN].fig[0].dN = dN;
 		rd->page[pN].fig[0].cX = cX;
 		rd->page[pN].fig[0].cY = N;
@@ -2617,6 +4771,8 @@ void readDatasetClean(read_t *rd, int dN)
 		readClose(rd, dN);
 	}
 
+	indexClean(rd, dN);
+
 	memset(&rd->data[dN], 0, sizeof(rd->data[0]));
 
 	plotFigureGarbage(rd->pl, dN);
@@ -2828,11 +4984,11 @@ scaleDataMap(plot_t *pl, int dN, int cN, fig_ops_t *ops)
 	return cN;
 }
 
-void readSelectPage(read_t *rd, int pN)
+void readSubtractPage(read_t *rd, int pN)
 {
 	plot_t		*pl = rd->pl;
 	page_t		*pg;
-	int		N, cX, cY;
+	int		N, cX;
 
 	if (pN < 0 || pN >= READ_PAGE_MAX) {
 
@@ -2845,8 +5001,52 @@ void readSelectPage(read_t *rd, int pN)
 	if (pg->busy == 0)
 		return;
 
+	/* Compute subtract columns that page needs but keep those that are
+	 * already in use.
+	 * */
+	for (N = 0; N < PLOT_FIGURE_MAX; ++N) {
+
+		if (pg->fig[N].busy != 0) {
+
+			cX = timeDataMap(pl, pg->fig[N].dN, pg->fig[N].cX);
+			scaleDataMap(pl, pg->fig[N].dN, cX, &pg->fig[N].ops[0]);
+			scaleDataMap(pl, pg->fig[N].dN, pg->fig[N].cY, &pg->fig[N].ops[1]);
+		}
+	}
+}
+
+void readSelectPage(read_t *rd, int pN)
+{
+	if (pN < 0 || pN >= READ_PAGE_MAX) {
+
+		ERROR("Page number is out of range\n");
+		return ;
+	}
+
+	if (rd->page[pN].busy == 0)
+		return;
+
 	rd->page_N = pN;
 
+	readSelectPagePlot(rd, rd->pl, pN);
+}
+
+void readSelectPagePlot(read_t *rd, plot_t *pl, int pN)
+{
+	page_t		*pg;
+	int		N, cX, cY;
+
+	if (pN < 0 || pN >= READ_PAGE_MAX) {
+
+		ERROR("Page number is out of range\n");
+		return ;
+	}
+
+	pg = rd->page + pN;
+
+	if (pg->busy == 0)
+		return;
+
 	plotFigureClean(pl);
 
 	plotDataRangeCacheSubtractClean(pl);
@@ -2868,6 +5068,14 @@ void readSelectPage(read_t *rd, int pN)
 				pl->figure[N].drawing = pg->fig[N].drawing;
 				pl->figure[N].width = pg->fig[N].width;
 			}
+
+			if (pg->fig[N].persist != FIGURE_PERSIST_DISABLED) {
+
+				pl->figure[N].persist = pg->fig[N].persist;
+				pl->figure[N].persist_column = pg->fig[N].persist_column;
+				pl->figure[N].persist_period = pg->fig[N].persist_period;
+				pl->figure[N].persist_decay = pg->fig[N].persist_decay;
+			}
 		}
 	}
 
@@ -3055,6 +5263,14 @@ void readCombinePage(read_t *rd, int pN, int remap)
 				pl->figure[fN].drawing = pg->fig[N].drawing;
 				pl->figure[fN].width = pg->fig[N].width;
 			}
+
+			if (pg->fig[N].persist != FIGURE_PERSIST_DISABLED) {
+
+				pl->figure[fN].persist = pg->fig[N].persist;
+				pl->figure[fN].persist_column = pg->fig[N].persist_column;
+				pl->figure[fN].persist_period = pg->fig[N].persist_period;
+				pl->figure[fN].persist_decay = pg->fig[N].persist_decay;
+			}
 		}
 	}
 
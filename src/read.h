@@ -32,6 +32,10 @@
 #define READ_TOKEN_MAX		80
 #define READ_FILE_PATH_MAX	800
 #define READ_TEXT_HEADER_MAX	9
+#define READ_TEXT_PROBE_MAX	1000
+#define READ_INDEX_SUFFIX	".gpindex"
+#define READ_NPY_HEADER_MAX	4096
+#define READ_SHM_MAGIC		"GPRING1"
 
 #define GP_MIN_SIZE_X		640
 #define GP_MIN_SIZE_Y		480
@@ -41,6 +45,9 @@ enum {
 	FORMAT_PLAIN_TEXT,
 	FORMAT_BINARY_FLOAT,
 	FORMAT_BINARY_DOUBLE,
+	FORMAT_BINARY_STRUCT,
+	FORMAT_BINARY_NPY,
+	FORMAT_BINARY_SHM,
 
 #ifdef _WINDOWS
 	FORMAT_BINARY_LEGACY_V1,
@@ -55,13 +62,69 @@ enum {
 	DATA_HINT_OCT
 };
 
+enum {
+	FIELD_U8			= 0,
+	FIELD_I8,
+	FIELD_U16,
+	FIELD_I16,
+	FIELD_U32,
+	FIELD_I32,
+	FIELD_U64,
+	FIELD_I64,
+	FIELD_F32,
+	FIELD_F64
+};
+
 typedef unsigned long long	ulen_t;
 
+typedef struct {
+
+	int		type;
+	long long	offset;
+	int		swap;
+	int		scaled;
+	double		scale;
+	double		bias;
+}
+field_t;
+
+/* Shared memory ring of fixed size rows with a single producer. Producer
+ * writes the row then increments head, we take rows up to head and then
+ * increment tail to give the space back. Both counters never wrap, the
+ * row number N is at header_size + (N % capacity) * row_size. Counters
+ * are on separate cache lines.
+ * */
+typedef struct {
+
+	char			magic[8];
+	unsigned int		header_size;
+	unsigned int		row_size;
+	unsigned long long	capacity;
+	unsigned int		closed;
+	unsigned int		reserved[9];
+
+	unsigned long long	head;
+	unsigned long long	pad_head[7];
+
+	unsigned long long	tail;
+	unsigned long long	pad_tail[7];
+}
+shm_ring_t;
+
+enum {
+	MARKUP_SPACE		= 1,
+	MARKUP_LEND		= 2
+};
+
 typedef struct {
 
 	char		delim;
 	char		space[READ_TOKEN_MAX];
 	char		lend[READ_TOKEN_MAX];
+
+	/* Character classes, zero is also taken as line end.
+	 * */
+	unsigned char	map[256];
 }
 markup_t;
 
@@ -87,6 +150,11 @@ typedef struct {
 		int		drawing;
 		int		width;
 
+		int		persist;
+		int		persist_column;
+		double		persist_period;
+		double		persist_decay;
+
 		int		dN;
 		int		cX;
 		int		cY;
@@ -151,11 +219,23 @@ typedef struct {
 	int		chunk;
 	int		timeout;
 	int		length_N;
+	int		projection;
+	int		index_step;
+
+	int		stride;
+	int		window_cN;
+	double		window_min;
+	double		window_max;
 
 	struct {
 
 		int		follow;
 
+		/* Source is not a regular file so it may never come to
+		 * the end like a socket or serial port.
+		 * */
+		int		live;
+
 		int		format;
 		int		column_N;
 		int		length_N;
@@ -171,13 +251,69 @@ typedef struct {
 
 		char		label[READ_COLUMN_MAX][READ_TOKEN_MAX];
 
-		int		hint[READ_COLUMN_MAX];
+		/* Hints are changed by UI thread while the text reader
+		 * may promote an unhinted column to hex on the fly.
+		 * */
+		SDL_atomic_t	hint[READ_COLUMN_MAX];
+
+		/* With projection only the columns that are referenced are
+		 * converted, the rest are stored as NaN. Reader is deferred
+		 * until the config is over as figures are not yet known.
+		 * */
+		int		projection;
+		int		deferred;
+		int		used[READ_COLUMN_MAX];
+
+		/* Sparse index of row offsets in the text file. It is
+		 * loaded from the file next to data or built while reading.
+		 * */
+		long long	*index;
+		int		index_N;
+		int		index_max;
+		int		index_row;
+		int		index_build;
+		int		index_first;
+		long long	index_origin;
+
+		/* Load only one of stride rows and the rows that have time
+		 * column within window.
+		 * */
+		int		stride;
+		int		window;
+		int		window_cN;
+		double		window_min;
+		double		window_max;
+
+		/* Record layout of the binary struct file.
+		 * */
+		field_t		field[READ_COLUMN_MAX];
+		int		record;
+
+		/* NumPy file is mapped into memory and rows are decoded
+		 * from there.
+		 * */
+		char		*map;
+		ulen_t		map_size;
+		int		map_alloc;
+		long long	map_base;
+		long long	map_step;
+		long long	map_row;
+		long long	map_N;
+
+		/* Shared memory ring is mapped the same way, rows from
+		 * map_row up to map_N are taken from the producer.
+		 * */
+		long long	shm_capacity;
+		int		shm_timeout;
+		int		shm_tick;
 	}
 	data[PLOT_DATASET_MAX];
 
 	page_t		page[READ_PAGE_MAX];
 
 	int		files_N;
+	int		read_budget;
+	int		config_busy;
 
 	int		bind_N;
 	int		page_N;
@@ -190,6 +326,9 @@ void readClean(read_t *rd);
 void readOpenUnified(read_t *rd, int dN, int cN, int lN, const char *file, int fmt);
 void readToggleHint(read_t *rd, int dN, int cN);
 int readUpdate(read_t *rd);
+void readUpdateAll(read_t *rd);
+int readPolled(read_t *rd);
+void readProjection(read_t *rd);
 
 #ifdef _WINDOWS
 void legacy_ACP_to_UTF8(char *ustr, const char *text, int n);
@@ -208,6 +347,8 @@ int readGetTimeColumn(read_t *rd, int dN);
 void readSetTimeColumn(read_t *rd, int dN, int cX);
 
 void readSelectPage(read_t *rd, int pN);
+void readSelectPagePlot(read_t *rd, plot_t *pl, int pN);
+void readSubtractPage(read_t *rd, int pN);
 void readCombinePage(read_t *rd, int pN, int remap);
 void readDataReload(read_t *rd);
 
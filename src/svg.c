@@ -18,8 +18,10 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
 #include <errno.h>
+#include <math.h>
 
 #include <SDL2/SDL.h>
 
@@ -28,11 +30,234 @@
 #include "plot.h"
 #include "read.h"
 
+static void
+svgFlush(svg_t *g)
+{
+	if (g->_buf_len != 0) {
+
+		fwrite(g->_buf, 1, g->_buf_len, g->fd);
+		g->_buf_len = 0;
+	}
+}
+
+static void
+svgPrintf(svg_t *g, const char *fmt, ...)
+{
+	va_list		ap;
+	int		room, n;
+
+	room = SVG_BUFFER_SIZE - g->_buf_len;
+
+	va_start(ap, fmt);
+	n = vsnprintf(g->_buf + g->_buf_len, room, fmt, ap);
+	va_end(ap);
+
+	if (n >= room) {
+
+		svgFlush(g);
+
+		va_start(ap, fmt);
+
+		if (n < SVG_BUFFER_SIZE) {
+
+			n = vsnprintf(g->_buf, SVG_BUFFER_SIZE, fmt, ap);
+			g->_buf_len = n;
+		}
+		else {
+			vfprintf(g->fd, fmt, ap);
+		}
+
+		va_end(ap);
+	}
+	else if (n > 0) {
+
+		g->_buf_len += n;
+	}
+}
+
+static char *
+svgFormat(char *s, double x)
+{
+	char		tbuf[24], *t = tbuf;
+	long		n;
+
+	/* Fast equivalent of "%.1f" for the coordinates.
+	 * */
+	x = (x < -1E+9) ? -1E+9 : (x > 1E+9) ? 1E+9 : x;
+	n = (long) floor(x * 10. + .5);
+
+	if (n < 0) {
+
+		*s++ = '-';
+		n = - n;
+	}
+
+	*t++ = '0' + (int) (n % 10);
+	*t++ = '.';
+
+	n /= 10;
+
+	do {
+		*t++ = '0' + (int) (n % 10);
+		n /= 10;
+	}
+	while (n != 0);
+
+	do { *s++ = *--t; } while (t != tbuf);
+
+	return s;
+}
+
+static void
+svgPutPoint(svg_t *g, double x, double y)
+{
+	char		*s;
+
+	if (g->_buf_len > SVG_BUFFER_SIZE - 64) {
+
+		svgFlush(g);
+	}
+
+	s = g->_buf + g->_buf_len;
+
+	*s++ = ' ';
+	s = svgFormat(s, x);
+	*s++ = ',';
+	s = svgFormat(s, y);
+
+	g->_buf_len = (int) (s - g->_buf);
+}
+
+static int
+svgSleeveFit(svg_t *g, double x, double y)
+{
+	double		dx, dy, r, dev;
+
+	dx = x - g->_anchor_x;
+	dy = y - g->_anchor_y;
+
+	r = sqrt(dx * dx + dy * dy);
+
+	if (r < g->_sleeve_r - SVG_SIMPLIFY_TOLERANCE) {
+
+		/* Path turns back so we must keep the farthest point.
+		 * */
+		return 0;
+	}
+
+	if (r <= SVG_SIMPLIFY_TOLERANCE || g->_sleeve_on == 0) {
+
+		return 1;
+	}
+
+	dev = atan2(dy, dx) - g->_sleeve_dir;
+	dev = (dev > M_PI) ? dev - 2. * M_PI : (dev < - M_PI) ? dev + 2. * M_PI : dev;
+
+	return (dev >= g->_sleeve_lo && dev <= g->_sleeve_hi) ? 1 : 0;
+}
+
+static void
+svgSleeveUpdate(svg_t *g, double x, double y)
+{
+	double		dx, dy, r, dir, dev, span;
+
+	dx = x - g->_anchor_x;
+	dy = y - g->_anchor_y;
+
+	r = sqrt(dx * dx + dy * dy);
+
+	g->_sleeve_r = (r > g->_sleeve_r) ? r : g->_sleeve_r;
+
+	if (r <= SVG_SIMPLIFY_TOLERANCE)
+		return ;
+
+	dir = atan2(dy, dx);
+	span = asin(SVG_SIMPLIFY_TOLERANCE / r);
+
+	if (g->_sleeve_on == 0) {
+
+		g->_sleeve_dir = dir;
+		g->_sleeve_lo = - span;
+		g->_sleeve_hi = span;
+		g->_sleeve_on = 1;
+	}
+	else {
+		dev = dir - g->_sleeve_dir;
+		dev = (dev > M_PI) ? dev - 2. * M_PI : (dev < - M_PI) ? dev + 2. * M_PI : dev;
+
+		g->_sleeve_lo = (dev - span > g->_sleeve_lo) ? dev - span : g->_sleeve_lo;
+		g->_sleeve_hi = (dev + span < g->_sleeve_hi) ? dev + span : g->_sleeve_hi;
+	}
+}
+
+static void
+svgLineAnchor(svg_t *g, double x, double y)
+{
+	g->_anchor_x = x;
+	g->_anchor_y = y;
+
+	g->_sleeve_r = 0.;
+	g->_sleeve_on = 0;
+}
+
+static void
+svgLinePoint(svg_t *g, double x, double y)
+{
+	if (g->_pending != 0 && svgSleeveFit(g, x, y) == 0) {
+
+		svgPutPoint(g, g->_last_x, g->_last_y);
+		svgLineAnchor(g, g->_last_x, g->_last_y);
+	}
+
+	svgSleeveUpdate(g, x, y);
+
+	g->_last_x = x;
+	g->_last_y = y;
+
+	g->_pending = 1;
+}
+
+static void
+svgLineMove(svg_t *g, double x, double y)
+{
+	svgPutPoint(g, x, y);
+	svgLineAnchor(g, x, y);
+
+	g->_last_x = x;
+	g->_last_y = y;
+
+	g->_pending = 0;
+}
+
+static void
+svgLineClose(svg_t *g)
+{
+	if (g->_line_open == 1) {
+
+		if (g->_pending != 0) {
+
+			svgPutPoint(g, g->_last_x, g->_last_y);
+		}
+
+		svgPrintf(g, "\"/>\n");
+
+		g->_line_open = 0;
+		g->_pending = 0;
+	}
+}
+
 svg_t *svgOpenNew(const char *file, int width, int height)
 {
 	svg_t		*g;
 
 	g = calloc(1, sizeof(svg_t));
+
+	if (g == NULL) {
+
+		ERROR("No memory allocated for SVG\n");
+		return NULL;
+	}
+
 	g->fd = unified_fopen(file, "w");
 
 	if (g->fd == NULL) {
@@ -43,7 +268,7 @@ svg_t *svgOpenNew(const char *file, int width, int height)
 		return NULL;
 	}
 
-	fprintf(g->fd, "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+	svgPrintf(g, "<svg xmlns=\"http://www.w3.org/2000/svg\" "
 			"width=\"%dpx\" height=\"%dpx\"><g>\n", width, height);
 
 	g->_line_open = 0;
@@ -53,13 +278,10 @@ svg_t *svgOpenNew(const char *file, int width, int height)
 
 void svgClose(svg_t *g)
 {
-	if (g->_line_open == 1) {
+	svgLineClose(g);
 
-		fprintf(g->fd, "\"/>\n");
-		g->_line_open = 0;
-	}
-
-	fprintf(g->fd, "</g></svg>\n");
+	svgPrintf(g, "</g></svg>\n");
+	svgFlush(g);
 
 	fclose(g->fd);
 	free(g);
@@ -69,82 +291,97 @@ void svgDrawLine(svg_t *g, double xs, double ys, double xe, double ye, svgCol_t
 {
 	if (g->_line_open == 1) {
 
-		if (xs == g->_last_x && ys == g->_last_y) {
+		if (		g->_line_col != col || g->_line_h != h
+				|| g->_line_d != d || g->_line_s != s) {
 
-			fprintf(g->fd, " %.1f,%.1f", xe, ye);
+			svgLineClose(g);
+		}
+		else if (xs == g->_last_x && ys == g->_last_y) {
+
+			svgLinePoint(g, xe, ye);
+			return ;
 		}
 		else if (xe == g->_last_x && ye == g->_last_y) {
 
-			fprintf(g->fd, " %.1f,%.1f", xs, ys);
+			svgLinePoint(g, xs, ys);
+			return ;
 		}
 		else {
-			fprintf(g->fd, "\"/>\n");
-			g->_line_open = 0;
-		}
-	}
+			/* Start a new subpath in the same element as style
+			 * is unchanged.
+			 * */
+			if (g->_pending != 0) {
 
-	if (g->_line_open == 0) {
+				svgPutPoint(g, g->_last_x, g->_last_y);
+			}
 
-		if (d == 0) {
+			svgPrintf(g, " M");
+			svgLineMove(g, xs, ys);
+			svgLinePoint(g, xe, ye);
 
-			fprintf(g->fd, "<path style=\"fill:none;stroke:#%06x;stroke-width:%.1f;"
-					"stroke-linejoin:round;stroke-linecap:round\" "
-					"d=\"M %.1f,%.1f %.1f,%.1f",
-					(int) (col & 0xFFFFFF), (h != 0) ? h : 0.5, xs, ys, xe, ye);
-		}
-		else {
-			fprintf(g->fd, "<path style=\"fill:none;stroke:#%06x;stroke-width:%.1f;"
-					"stroke-linejoin:round;stroke-linecap:round;"
-					"stroke-dasharray:%d,%d\" "
-					"d=\"M %.1f,%.1f %.1f,%.1f",
-					(int) (col & 0xFFFFFF), (h != 0) ? h : 0.5, d, s,
-					xs, ys, xe, ye);
+			return ;
 		}
+	}
 
-		g->_line_open = 1;
+	if (d == 0) {
+
+		svgPrintf(g, "<path style=\"fill:none;stroke:#%06x;stroke-width:%.1f;"
+				"stroke-linejoin:round;stroke-linecap:round\" d=\"M",
+				(int) (col & 0xFFFFFF), (h != 0) ? h : 0.5);
 	}
+	else {
+		svgPrintf(g, "<path style=\"fill:none;stroke:#%06x;stroke-width:%.1f;"
+				"stroke-linejoin:round;stroke-linecap:round;"
+				"stroke-dasharray:%d,%d\" d=\"M",
+				(int) (col & 0xFFFFFF), (h != 0) ? h : 0.5, d, s);
+	}
+
+	g->_line_open = 1;
+	g->_line_col = col;
+	g->_line_h = h;
+	g->_line_d = d;
+	g->_line_s = s;
 
-	g->_last_x = xe;
-	g->_last_y = ye;
+	svgLineMove(g, xs, ys);
+	svgLinePoint(g, xe, ye);
 }
 
 void svgDrawRect(svg_t *g, double xs, double ys, double xe, double ye, svgCol_t col)
 {
-	if (g->_line_open == 1) {
+	char		*p;
 
-		fprintf(g->fd, "\"/>\n");
-		g->_line_open = 0;
-	}
+	svgLineClose(g);
+
+	svgPrintf(g, "<path style=\"fill:#%06x;stroke:none\" d=\"M",
+			(int) (col & 0xFFFFFF));
+
+	svgPutPoint(g, xs, ys);
+	svgPutPoint(g, xe, ys);
+	svgPutPoint(g, xe, ye);
+	svgPutPoint(g, xs, ye);
+
+	p = g->_buf + g->_buf_len;
 
-	fprintf(g->fd, "<path style=\"fill:#%06x;stroke:none\" "
-			"d=\"M %.1f,%.1f %.1f,%.1f %.1f,%.1f %.1f,%.1f Z\"/>\n",
-			(int) (col & 0xFFFFFF), xs, ys, xe, ys, xe, ye, xs, ye);
+	memcpy(p, " Z\"/>\n", 6);
+	g->_buf_len += 6;
 }
 
 void svgDrawCircle(svg_t *g, double xs, double ys, double r, svgCol_t col)
 {
-	if (g->_line_open == 1) {
-
-		fprintf(g->fd, "\"/>\n");
-		g->_line_open = 0;
-	}
+	svgLineClose(g);
 
-	fprintf(g->fd, "<circle style=\"fill:#%06x;stroke:none\" "
+	svgPrintf(g, "<circle style=\"fill:#%06x;stroke:none\" "
 			"cx=\"%.1f\" cy=\"%.1f\" r=\"%.1f\"/>\n",
 			(int) (col & 0xFFFFFF), xs, ys, r);
 }
 
 void svgDrawText(svg_t *g, double xs, double ys, const char *text, svgCol_t col, int flags)
 {
-	if (g->_line_open == 1) {
-
-		fprintf(g->fd, "\"/>\n");
-		g->_line_open = 0;
-	}
+	svgLineClose(g);
 
 	if (flags & TEXT_VERTICAL) {
 
-		fprintf(g->fd, "<text style=\"font-family:%s;font-size:%dpx;fill:#%06x;stroke:none;"
+		svgPrintf(g, "<text style=\"font-family:%s;font-size:%dpx;fill:#%06x;stroke:none;"
 				"dominant-baseline:%s;text-anchor:%s\" "
 				"transform=\"rotate(-90,%.1f,%.1f)\" "
 				"x=\"%.1f\" y=\"%.1f\">%s</text>\n",
@@ -154,7 +391,7 @@ void svgDrawText(svg_t *g, double xs, double ys, const char *text, svgCol_t col,
 				xs, ys, xs, ys, text);
 	}
 	else {
-		fprintf(g->fd, "<text style=\"font-family:%s;font-size:%dpx;fill:#%06x;stroke:none;"
+		svgPrintf(g, "<text style=\"font-family:%s;font-size:%dpx;fill:#%06x;stroke:none;"
 				"dominant-baseline:%s;text-anchor:%s\" "
 				"x=\"%.1f\" y=\"%.1f\">%s</text>\n",
 				g->font_family, g->font_pt, (int) (col & 0xFFFFFF),
@@ -24,6 +24,9 @@
 
 #include <SDL2/SDL.h>
 
+#define SVG_BUFFER_SIZE			65536
+#define SVG_SIMPLIFY_TOLERANCE		0.25
+
 typedef Uint32		svgCol_t;
 
 typedef struct {
@@ -36,6 +39,27 @@ typedef struct {
 	int		_line_open;
 	double		_last_x;
 	double		_last_y;
+
+	svgCol_t	_line_col;
+	int		_line_h;
+	int		_line_d;
+	int		_line_s;
+
+	/* Polyline is simplified on the fly. Points that stay within the
+	 * tolerance of the segment from the anchor are not written.
+	 * */
+	double		_anchor_x;
+	double		_anchor_y;
+	int		_pending;
+
+	double		_sleeve_dir;
+	double		_sleeve_lo;
+	double		_sleeve_hi;
+	double		_sleeve_r;
+	int		_sleeve_on;
+
+	char		_buf[SVG_BUFFER_SIZE];
+	int		_buf_len;
 }
 svg_t;
 